@@ -0,0 +1,267 @@
+/*
+ * Copyright (C) 2014-2015 Daniel Gromer
+ *
+ * This file is part of PeakMan.
+ *
+ * PeakMan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * PeakMan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PeakMan.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "artifactdetector.h"
+#include "runningmedian.h"
+#include "runningquantile.h"
+#include <qmath.h>
+
+// Half windows in intervals, quartiles over 91 intervals, medians of the
+// decision method over 11
+static const int QuartileHalf = 45;
+static const int MedianHalf = 5;
+
+// Scale of the quartile deviation for the thresholds of the decision method
+static const double Alpha = 5.2;
+
+// Ectopic beat region of the decision method
+static const double C1 = 0.13;
+static const double C2 = 0.17;
+
+// Running median with a centered window of 2 * half + 1 values, shrinking at
+// the ends
+static QVector<double> runningMedian(const QVector<double> &values, int half)
+{
+    QVector<double> out(values.size());
+    RunningMedian median;
+
+    int lo = 0, hi = 0; // Window is [lo, hi)
+
+    for (int i = 0; i < values.size(); i++)
+    {
+        while (hi < qMin(values.size(), i + half + 1))
+        {
+            median.insert(values[hi++]);
+        }
+
+        while (lo < i - half)
+        {
+            median.remove(values[lo++]);
+        }
+
+        out[i] = median.median();
+    }
+
+    return out;
+}
+
+// Quartile deviation (Q3 - Q1) / 2 over the same windows
+static QVector<double> runningQuartileDeviation(const QVector<double> &values, int half)
+{
+    QVector<double> out(values.size());
+    RunningQuantile first(0.25);
+    RunningQuantile third(0.75);
+
+    int lo = 0, hi = 0;
+
+    for (int i = 0; i < values.size(); i++)
+    {
+        while (hi < qMin(values.size(), i + half + 1))
+        {
+            first.insert(values[hi]);
+            third.insert(values[hi]);
+            hi++;
+        }
+
+        while (lo < i - half)
+        {
+            first.remove(values[lo]);
+            third.remove(values[lo]);
+            lo++;
+        }
+
+        out[i] = (third.quantile() - first.quantile()) / 2;
+    }
+
+    return out;
+}
+
+ArtifactDetector::ArtifactDetector() : method(SuccessiveDifference)
+{
+
+}
+
+void ArtifactDetector::setMethod(Method method)
+{
+    this->method = method;
+}
+
+ArtifactDetector::Method ArtifactDetector::getMethod() const
+{
+    return method;
+}
+
+QVector<int> ArtifactDetector::detect(const QVector<double> &intervals) const
+{
+    switch (method)
+    {
+    case MedianDeviation:
+        return medianDeviation(intervals);
+    case DifferenceDecision:
+        return differenceDecision(intervals);
+    default:
+        return successiveDifference(intervals);
+    }
+}
+
+int ArtifactDetector::methodCount()
+{
+    return 3;
+}
+
+QString ArtifactDetector::methodName(Method method)
+{
+    switch (method)
+    {
+    case MedianDeviation:
+        return "MED/MAD";
+    case DifferenceDecision:
+        return "Lipponen-Tarvainen";
+    default:
+        return "Successive difference";
+    }
+}
+
+QVector<int> ArtifactDetector::successiveDifference(const QVector<double> &intervals)
+{
+    QVector<int> artifacts;
+
+    for (int i = 1; i < intervals.size(); i++)
+    {
+        if (qAbs(intervals[i] - intervals[i - 1]) > .2 * intervals[i - 1])
+        {
+            artifacts << i;
+        }
+    }
+
+    return artifacts;
+}
+
+QVector<int> ArtifactDetector::medianDeviation(const QVector<double> &intervals)
+{
+    int n = intervals.size();
+    QVector<int> artifacts;
+
+    if (n < 3) return artifacts;
+
+    QVector<double> differences(n, 0);
+
+    for (int i = 1; i < n; i++)
+    {
+        differences[i] = qAbs(intervals[i] - intervals[i - 1]);
+    }
+
+    QVector<double> deviation = runningQuartileDeviation(differences, QuartileHalf);
+    QVector<double> median = runningMedian(intervals, QuartileHalf);
+
+    bool previous = false;
+
+    for (int i = 1; i < n; i++)
+    {
+        // Criterion halfway between the maximum expected difference of normal
+        // beats and the minimal difference caused by an artifact
+        double expected = 3.32 * deviation[i];
+        double minimal = (median[i] - 2.9 * deviation[i]) / 3;
+        double criterion = (expected + minimal) / 2;
+
+        // A single interval that jumps away from both neighbours, or a run of
+        // intervals away from the local median that started with a jump
+        bool jump = differences[i] > criterion;
+        bool spike = jump && (i + 1 == n || differences[i + 1] > criterion);
+        bool run = qAbs(intervals[i] - median[i]) > criterion && (jump || previous);
+
+        previous = spike || run;
+
+        if (previous) artifacts << i;
+    }
+
+    return artifacts;
+}
+
+QVector<int> ArtifactDetector::differenceDecision(const QVector<double> &intervals)
+{
+    int n = intervals.size();
+    QVector<int> artifacts;
+
+    if (n < 3) return artifacts;
+
+    // Successive differences, normalized by their local quartile deviation
+    QVector<double> differences(n, 0);
+
+    for (int i = 1; i < n; i++)
+    {
+        differences[i] = intervals[i] - intervals[i - 1];
+    }
+
+    QVector<double> magnitudes(n);
+
+    for (int i = 0; i < n; i++)
+    {
+        magnitudes[i] = qAbs(differences[i]);
+    }
+
+    QVector<double> threshold = runningQuartileDeviation(magnitudes, QuartileHalf);
+
+    for (int i = 0; i < n; i++)
+    {
+        differences[i] = threshold[i] > 0 ? differences[i] / (Alpha * threshold[i]) : 0;
+    }
+
+    // Deviations from the local median, short intervals count twice
+    QVector<double> median = runningMedian(intervals, MedianHalf);
+    QVector<double> deviations(n);
+
+    for (int i = 0; i < n; i++)
+    {
+        deviations[i] = intervals[i] - median[i];
+
+        if (deviations[i] < 0) deviations[i] *= 2;
+
+        magnitudes[i] = qAbs(deviations[i]);
+    }
+
+    threshold = runningQuartileDeviation(magnitudes, QuartileHalf);
+
+    for (int i = 0; i < n; i++)
+    {
+        deviations[i] = threshold[i] > 0 ? deviations[i] / (Alpha * threshold[i]) : 0;
+    }
+
+    for (int i = 1; i < n; i++)
+    {
+        double d = differences[i];
+        double previous = differences[i - 1];
+        double next = i + 1 < n ? differences[i + 1] : d;
+        double afterNext = i + 2 < n ? differences[i + 2] : next;
+
+        // Ectopic beats, a jump followed by a jump back, compared with the
+        // larger neighbouring difference in the same direction
+        double s12 = d > 0 ? qMax(previous, next) : qMin(previous, next);
+        bool ectopic = (d > 1 && s12 < -C1 * d - C2) || (d < -1 && s12 > -C1 * d + C2);
+
+        // Long or short intervals, a jump not compensated by the next two
+        // differences, or far from the local median
+        double s22 = d >= 0 ? qMin(next, afterNext) : qMax(next, afterNext);
+        bool longShort = (d > 1 && s22 < -1) || (d < -1 && s22 > 1) || qAbs(deviations[i]) > 3;
+
+        if (ectopic || longShort) artifacts << i;
+    }
+
+    return artifacts;
+}
@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2014-2015 Daniel Gromer
+ *
+ * This file is part of PeakMan.
+ *
+ * PeakMan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * PeakMan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PeakMan.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ARTIFACTDETECTOR_H
+#define ARTIFACTDETECTOR_H
+
+#include <QVector>
+#include <QString>
+
+// Detection of artifacts in a sequence of interbeat intervals. Each method is
+// a single pass over the intervals, with the local statistics taken from
+// running medians and quartiles over windows centered on each interval.
+class ArtifactDetector
+{
+public:
+    enum Method
+    {
+        SuccessiveDifference, // More than 20% from the previous interval
+        MedianDeviation, // Berntson et al. (1990), maximum expected and minimal artifact difference
+        DifferenceDecision // Lipponen and Tarvainen (2019), decision on normalized successive differences
+    };
+
+    ArtifactDetector();
+
+    void setMethod(Method method);
+    Method getMethod() const;
+
+    QVector<int> detect(const QVector<double> &intervals) const; // Indices of artifacts, intervals in ms
+
+    static int methodCount();
+    static QString methodName(Method method);
+
+private:
+    static QVector<int> successiveDifference(const QVector<double> &intervals);
+    static QVector<int> medianDeviation(const QVector<double> &intervals);
+    static QVector<int> differenceDecision(const QVector<double> &intervals);
+
+    Method method;
+};
+
+#endif // ARTIFACTDETECTOR_H
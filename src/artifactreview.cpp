@@ -0,0 +1,235 @@
+/*
+ * Copyright (C) 2014-2015 Daniel Gromer
+ *
+ * This file is part of PeakMan.
+ *
+ * PeakMan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * PeakMan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PeakMan.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "artifactreview.h"
+#include <QPainter>
+#include <QKeyEvent>
+
+// Thumbnails kept ahead of and behind the current artifact
+static const int Ahead = 32;
+static const int Behind = 8;
+
+ArtifactReview::ArtifactReview(QWidget *parent) : QWidget(parent)
+{
+    setFocusPolicy(Qt::StrongFocus);
+    current = 0;
+}
+
+ArtifactReview::~ArtifactReview()
+{
+
+}
+
+void ArtifactReview::setCandidates(const QVector<int> &intervals, const QVector<double> &sizes)
+{
+    this->intervals = intervals;
+    this->sizes = sizes;
+    thumbnails = QVector<QImage>(intervals.size());
+    decisions = QVector<Decision>(intervals.size(), Undecided);
+    current = 0;
+
+    update();
+}
+
+void ArtifactReview::setThumbnail(int candidate, const QImage &image)
+{
+    if (candidate < 0 || candidate >= thumbnails.size() || !inWindow(candidate)) return;
+
+    thumbnails[candidate] = image;
+
+    // Thumbnails of other artifacts wait until they are shown
+    if (candidate == current) update();
+}
+
+void ArtifactReview::clear()
+{
+    setCandidates(QVector<int>(), QVector<double>());
+}
+
+int ArtifactReview::count() const
+{
+    return intervals.size();
+}
+
+int ArtifactReview::interval(int candidate) const
+{
+    return intervals.at(candidate);
+}
+
+QVector<int> ArtifactReview::missingThumbnails() const
+{
+    QVector<int> missing;
+
+    for (int i = current; i < qMin(current + Ahead + 1, intervals.size()); i++)
+    {
+        if (thumbnails[i].isNull()) missing << i;
+    }
+
+    for (int i = current - 1; i >= qMax(current - Behind, 0); i--)
+    {
+        if (thumbnails[i].isNull()) missing << i;
+    }
+
+    return missing;
+}
+
+QVector<int> ArtifactReview::accepted() const
+{
+    QVector<int> result;
+
+    for (int i = 0; i < decisions.size(); i++)
+    {
+        if (decisions[i] == Accepted) result << intervals[i];
+    }
+
+    return result;
+}
+
+int ArtifactReview::decidedCount(Decision decision) const
+{
+    return decisions.count(decision);
+}
+
+void ArtifactReview::paintEvent(QPaintEvent *)
+{
+    QPainter painter(this);
+    painter.fillRect(rect(), Qt::white);
+
+    if (intervals.isEmpty())
+    {
+        painter.setPen(QColor(150, 150, 150));
+        painter.drawText(rect(), Qt::AlignCenter, "No artifacts to review");
+        return;
+    }
+
+    int lineHeight = fontMetrics().height() + 4;
+    QRect imageRect = rect().adjusted(4, 4, -4, -lineHeight - 4);
+
+    const QImage &image = thumbnails[current];
+
+    if (image.isNull())
+    {
+        painter.setPen(QColor(150, 150, 150));
+        painter.drawText(imageRect, Qt::AlignCenter, "Rendering ...");
+    }
+    else
+    {
+        // Keep the aspect ratio, centered in the widget
+        QSize size = image.size().scaled(imageRect.size(), Qt::KeepAspectRatio);
+        QRect target(QPoint(0, 0), size);
+        target.moveCenter(imageRect.center());
+
+        painter.drawImage(target, image);
+
+        // Frame in the color of the decision
+        if (decisions[current] != Undecided)
+        {
+            QColor color = decisions[current] == Accepted ? QColor(113, 140, 0) : QColor(200, 40, 41);
+            painter.setPen(QPen(color, 3));
+            painter.drawRect(target.adjusted(1, 1, -2, -2));
+        }
+    }
+
+    QString decision = decisions[current] == Accepted ? "accepted" : (decisions[current] == Rejected ? "rejected" : "undecided");
+
+    painter.setPen(QColor(77, 77, 76));
+    painter.drawText(QRect(4, height() - lineHeight, width() - 8, lineHeight), Qt::AlignLeft | Qt::AlignVCenter,
+                     QString("Artifact %1 of %2, interval %3 (%4 ms), %5")
+                     .arg(current + 1).arg(intervals.size()).arg(intervals[current] + 1)
+                     .arg(qRound(sizes[current])).arg(decision));
+    painter.drawText(QRect(4, height() - lineHeight, width() - 8, lineHeight), Qt::AlignRight | Qt::AlignVCenter,
+                     QString("%1 accepted, %2 rejected").arg(decidedCount(Accepted)).arg(decidedCount(Rejected)));
+}
+
+void ArtifactReview::keyPressEvent(QKeyEvent *event)
+{
+    switch (event->key())
+    {
+    case Qt::Key_Right:
+    case Qt::Key_Space:
+        setCurrent(current + 1);
+        break;
+    case Qt::Key_Left:
+        setCurrent(current - 1);
+        break;
+    case Qt::Key_PageDown:
+        setCurrent(current + 10);
+        break;
+    case Qt::Key_PageUp:
+        setCurrent(current - 10);
+        break;
+    case Qt::Key_Home:
+        setCurrent(0);
+        break;
+    case Qt::Key_End:
+        setCurrent(intervals.size() - 1);
+        break;
+    case Qt::Key_A:
+    case Qt::Key_Return:
+    case Qt::Key_Enter:
+        decide(Accepted);
+        break;
+    case Qt::Key_R:
+    case Qt::Key_Delete:
+        decide(Rejected);
+        break;
+    default:
+        QWidget::keyPressEvent(event);
+    }
+}
+
+void ArtifactReview::mousePressEvent(QMouseEvent *event)
+{
+    setFocus();
+
+    QWidget::mousePressEvent(event);
+}
+
+void ArtifactReview::setCurrent(int candidate)
+{
+    if (intervals.isEmpty()) return;
+
+    current = qBound(0, candidate, intervals.size() - 1);
+
+    // Drop the thumbnails that left the window
+    for (int i = 0; i < thumbnails.size(); i++)
+    {
+        if (!inWindow(i) && !thumbnails[i].isNull()) thumbnails[i] = QImage();
+    }
+
+    update();
+
+    emit currentChanged(current);
+}
+
+void ArtifactReview::decide(Decision decision)
+{
+    if (intervals.isEmpty()) return;
+
+    decisions[current] = decision;
+
+    emit decisionsChanged();
+
+    setCurrent(current + 1);
+}
+
+bool ArtifactReview::inWindow(int candidate) const
+{
+    return candidate >= current - Behind && candidate <= current + Ahead;
+}
@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2014-2015 Daniel Gromer
+ *
+ * This file is part of PeakMan.
+ *
+ * PeakMan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * PeakMan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PeakMan.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ARTIFACTREVIEW_H
+#define ARTIFACTREVIEW_H
+
+#include <QWidget>
+#include <QImage>
+#include <QVector>
+
+// Review queue of detected artifacts, one pre-rendered thumbnail at a time
+// (see ArtifactThumbnails). Only thumbnails of a window around the current
+// artifact are kept, the others are dropped as the review moves on. Keys:
+//  - Right, Space / Left: next / previous artifact
+//  - Page Down / Page Up: ten artifacts ahead / back
+//  - A, Return: accept as artifact and move on
+//  - R, Delete: reject as false detection and move on
+class ArtifactReview : public QWidget
+{
+    Q_OBJECT
+
+public:
+    enum Decision { Undecided, Accepted, Rejected };
+
+    explicit ArtifactReview(QWidget *parent);
+    ~ArtifactReview();
+
+    void setCandidates(const QVector<int> &intervals, const QVector<double> &sizes); // Interval indices and sizes in ms
+    void setThumbnail(int candidate, const QImage &image); // Ignored outside the window
+    void clear();
+
+    int count() const;
+    int interval(int candidate) const;
+    QVector<int> missingThumbnails() const; // Candidates of the window without a thumbnail, current first
+    QVector<int> accepted() const; // Interval indices
+    int decidedCount(Decision decision) const;
+
+signals:
+    void decisionsChanged(); // An artifact was accepted or rejected
+    void currentChanged(int candidate);
+
+protected:
+    void paintEvent(QPaintEvent *event);
+    void keyPressEvent(QKeyEvent *event);
+    void mousePressEvent(QMouseEvent *event);
+
+private:
+    void setCurrent(int candidate);
+    void decide(Decision decision);
+    bool inWindow(int candidate) const;
+
+    QVector<int> intervals;
+    QVector<double> sizes;
+    QVector<QImage> thumbnails; // Null until rendered
+    QVector<Decision> decisions;
+    int current;
+};
+
+#endif // ARTIFACTREVIEW_H
@@ -0,0 +1,185 @@
+/*
+ * Copyright (C) 2014-2015 Daniel Gromer
+ *
+ * This file is part of PeakMan.
+ *
+ * PeakMan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * PeakMan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PeakMan.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "artifactthumbnails.h"
+#include <QtConcurrentMap>
+#include <QPainter>
+#include <qmath.h>
+
+struct ThumbnailTask
+{
+    ECGSignal signal; // Shared, copies of an ECGSignal are cheap
+    double sampleRate;
+    QSize size;
+    double from; // Shown time range in seconds
+    double to;
+    double start; // Artifact interval
+    double end;
+    QVector<double> peaks; // Peaks within the shown range
+};
+
+static QImage renderThumbnail(const ThumbnailTask &task)
+{
+    QImage image(task.size, QImage::Format_RGB32);
+    image.fill(Qt::white);
+
+    int first = qMax(0, qFloor(task.from * task.sampleRate));
+    int last = qMin(task.signal.size() - 1, qCeil(task.to * task.sampleRate));
+
+    if (last <= first) return image;
+
+    QVector<double> samples(last - first + 1);
+    task.signal.read(first, samples.size(), samples.data());
+
+    double lower = samples[0], upper = samples[0];
+
+    for (int i = 1; i < samples.size(); i++)
+    {
+        lower = qMin(lower, samples[i]);
+        upper = qMax(upper, samples[i]);
+    }
+
+    double margin = qMax(upper - lower, 1e-9) * 0.05;
+    lower -= margin;
+    upper += margin;
+
+    int width = task.size.width();
+    int height = task.size.height();
+    double seconds = task.to - task.from;
+
+    QPainter painter(&image);
+    painter.setRenderHint(QPainter::Antialiasing);
+
+    // Artifact interval
+    double x0 = (task.start - task.from) / seconds * width;
+    double x1 = (task.end - task.from) / seconds * width;
+    painter.fillRect(QRectF(x0, 0, x1 - x0, height), QColor(234, 183, 0, 60));
+
+    // Min and max of the samples of each pixel column, connected to the
+    // previous column, like the zoomed out ecg plot
+    painter.setPen(QPen(QColor(77, 77, 76), 1));
+
+    double previous = 0;
+
+    for (int column = 0; column < width; column++)
+    {
+        int from = (int) ((double) column / width * (samples.size() - 1));
+        int to = qMax(from, (int) ((double) (column + 1) / width * (samples.size() - 1)));
+
+        double minimum = samples[from], maximum = samples[from];
+
+        for (int i = from + 1; i <= to; i++)
+        {
+            minimum = qMin(minimum, samples[i]);
+            maximum = qMax(maximum, samples[i]);
+        }
+
+        double top = (upper - maximum) / (upper - lower) * height;
+        double bottom = (upper - minimum) / (upper - lower) * height;
+
+        if (column > 0)
+        {
+            top = qMin(top, previous);
+            bottom = qMax(bottom, previous);
+        }
+
+        painter.drawLine(QPointF(column + 0.5, top), QPointF(column + 0.5, bottom));
+
+        previous = (upper - samples[to]) / (upper - lower) * height;
+    }
+
+    // Peaks
+    painter.setPen(QPen(QColor(200, 40, 41), 1));
+
+    for (int i = 0; i < task.peaks.size(); i++)
+    {
+        double x = (task.peaks[i] - task.from) / seconds * width;
+        painter.drawLine(QPointF(x, 0), QPointF(x, height * 0.1));
+    }
+
+    // Size of the interval
+    painter.setPen(QColor(77, 77, 76));
+    painter.drawText(QRectF(x0, 0, qMax(x1 - x0, 60.0), height), Qt::AlignHCenter | Qt::AlignBottom,
+                     QString::number(qRound((task.end - task.start) * 1000)) + " ms");
+
+    return image;
+}
+
+ArtifactThumbnails::ArtifactThumbnails()
+{
+    size = QSize(480, 160);
+    context = 2;
+}
+
+void ArtifactThumbnails::setSize(const QSize &size)
+{
+    this->size = size;
+}
+
+QSize ArtifactThumbnails::getSize() const
+{
+    return size;
+}
+
+void ArtifactThumbnails::setContext(double seconds)
+{
+    context = seconds;
+}
+
+double ArtifactThumbnails::getContext() const
+{
+    return context;
+}
+
+QFuture<QImage> ArtifactThumbnails::start(const ECGSignal &signal, double sampleRate, const QVector<double> &peaks, const QVector<int> &artifacts) const
+{
+    QVector<ThumbnailTask> tasks;
+
+    for (int a = 0; a < artifacts.size(); a++)
+    {
+        int i = artifacts[a];
+
+        ThumbnailTask task;
+        task.signal = signal;
+        task.sampleRate = sampleRate;
+        task.size = size;
+
+        if (i >= 0 && i + 1 < peaks.size())
+        {
+            task.start = peaks[i];
+            task.end = peaks[i + 1];
+        }
+        else
+        {
+            task.start = task.end = 0;
+        }
+
+        task.from = task.start - context;
+        task.to = task.end + context;
+
+        for (int p = qMax(0, i - 16); p < qMin(peaks.size(), i + 18); p++)
+        {
+            if (peaks[p] >= task.from && peaks[p] <= task.to) task.peaks << peaks[p];
+        }
+
+        tasks << task;
+    }
+
+    return QtConcurrent::mapped(tasks, renderThumbnail);
+}
@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2014-2015 Daniel Gromer
+ *
+ * This file is part of PeakMan.
+ *
+ * PeakMan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * PeakMan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PeakMan.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ARTIFACTTHUMBNAILS_H
+#define ARTIFACTTHUMBNAILS_H
+
+#include <QVector>
+#include <QFuture>
+#include <QImage>
+#include <QSize>
+#include "ecgsignal.h"
+
+// Pre-rendered ecg context of artifact intervals for reviewing them. Each
+// thumbnail is drawn into a QImage on the global thread pool, without a
+// widget or replot involved, so browsing them is just showing an image.
+// The future keeps all images of a call, so render a batch of artifacts
+// around the reviewed one at a time.
+class ArtifactThumbnails
+{
+public:
+    ArtifactThumbnails();
+
+    void setSize(const QSize &size);
+    QSize getSize() const;
+    void setContext(double seconds); // Shown before and after the interval
+    double getContext() const;
+
+    // Renders one thumbnail per artifact, interval i ends at peak i + 1.
+    // Results arrive in the order of the artifacts and can be collected
+    // with a QFutureWatcher.
+    QFuture<QImage> start(const ECGSignal &signal, double sampleRate, const QVector<double> &peaks, const QVector<int> &artifacts) const;
+
+private:
+    QSize size;
+    double context;
+};
+
+#endif // ARTIFACTTHUMBNAILS_H
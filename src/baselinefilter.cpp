@@ -0,0 +1,150 @@
+/*
+ * Copyright (C) 2014-2015 Daniel Gromer
+ *
+ * This file is part of PeakMan.
+ *
+ * PeakMan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * PeakMan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PeakMan.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "baselinefilter.h"
+#include "runningmedian.h"
+#include <QThread>
+#include <QtConcurrentMap>
+
+// Samples per chunk, chunks are processed in parallel
+static const int ChunkSize = 65536;
+
+struct BaselineChunk
+{
+    const ECGSignal *signal;
+    int start;
+    int count;
+    int firstHalf; // Half window sizes in samples
+    int secondHalf;
+    QVector<double> baseline;
+};
+
+// Running median with a centered window of 2 * half + 1 samples, shrinking at
+// the ends of the input. The input holds samples [offset, size), in[0] being
+// sample offset. Computes out[i - from] for i in [from, to).
+static void runningMedian(const double *in, int offset, int size, int half, int from, int to, double *out)
+{
+    RunningMedian median;
+
+    int lo = qMax(offset, from - half);
+    int hi = lo; // Window is [lo, hi)
+
+    for (int i = from; i < to; i++)
+    {
+        while (hi < qMin(size, i + half + 1))
+        {
+            median.insert(in[hi++ - offset]);
+        }
+
+        while (lo < i - half)
+        {
+            median.remove(in[lo++ - offset]);
+        }
+
+        out[i - from] = median.median();
+    }
+}
+
+static void estimateBaseline(BaselineChunk &chunk)
+{
+    int n = chunk.signal->size();
+
+    // The second median needs the first one around the chunk, which in turn
+    // needs the samples around that
+    int firstFrom = qMax(0, chunk.start - chunk.secondHalf);
+    int firstTo = qMin(n, chunk.start + chunk.count + chunk.secondHalf);
+    int readFrom = qMax(0, firstFrom - chunk.firstHalf);
+    int readTo = qMin(n, firstTo + chunk.firstHalf);
+
+    QVector<double> samples(readTo - readFrom);
+    chunk.signal->read(readFrom, samples.size(), samples.data());
+
+    QVector<double> first(firstTo - firstFrom);
+    runningMedian(samples.constData(), readFrom, readTo, chunk.firstHalf, firstFrom, firstTo, first.data());
+
+    chunk.baseline.resize(chunk.count);
+    runningMedian(first.constData(), firstFrom, firstTo, chunk.secondHalf, chunk.start, chunk.start + chunk.count, chunk.baseline.data());
+}
+
+BaselineFilter::BaselineFilter()
+{
+    firstWindow = .2;
+    secondWindow = .6;
+}
+
+void BaselineFilter::setWindows(double first, double second)
+{
+    firstWindow = first;
+    secondWindow = second;
+}
+
+ECGSignal BaselineFilter::apply(const ECGSignal &signal, double sampleRate, ECGSignal *baseline) const
+{
+    ECGSignal corrected;
+
+    if (baseline) baseline->clear();
+
+    if (signal.isEmpty()) return signal;
+
+    int n = signal.size();
+    int chunks = (n + ChunkSize - 1) / ChunkSize;
+    int batchSize = 2 * qMax(1, QThread::idealThreadCount());
+
+    QVector<double> samples(ChunkSize);
+
+    for (int firstChunk = 0; firstChunk < chunks; firstChunk += batchSize)
+    {
+        QVector<BaselineChunk> batch;
+
+        for (int c = firstChunk; c < qMin(chunks, firstChunk + batchSize); c++)
+        {
+            BaselineChunk chunk;
+            chunk.signal = &signal;
+            chunk.start = c * ChunkSize;
+            chunk.count = qMin(ChunkSize, n - chunk.start);
+            chunk.firstHalf = qRound(firstWindow * sampleRate / 2);
+            chunk.secondHalf = qRound(secondWindow * sampleRate / 2);
+
+            batch << chunk;
+        }
+
+        QtConcurrent::blockingMap(batch, estimateBaseline);
+
+        // Subtract the baseline, chunk by chunk in order
+        for (int c = 0; c < batch.size(); c++)
+        {
+            signal.read(batch[c].start, batch[c].count, samples.data());
+
+            for (int i = 0; i < batch[c].count; i++)
+            {
+                corrected.append(samples[i] - batch[c].baseline[i]);
+
+                if (baseline) baseline->append(batch[c].baseline[i]);
+            }
+
+            batch[c].baseline.clear();
+        }
+    }
+
+    corrected.squeeze();
+
+    if (baseline) baseline->squeeze();
+
+    return corrected;
+}
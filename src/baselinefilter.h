@@ -0,0 +1,42 @@
+/*
+ * Copyright (C) 2014-2015 Daniel Gromer
+ *
+ * This file is part of PeakMan.
+ *
+ * PeakMan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * PeakMan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PeakMan.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BASELINEFILTER_H
+#define BASELINEFILTER_H
+
+#include "ecgsignal.h"
+
+// Baseline wander removal with two running medians: the first window removes
+// the QRS complexes, the second one the P and T waves. What is left is the
+// baseline, which is subtracted from the signal.
+class BaselineFilter
+{
+public:
+    BaselineFilter();
+
+    void setWindows(double first, double second); // In seconds
+
+    ECGSignal apply(const ECGSignal &signal, double sampleRate, ECGSignal *baseline = 0) const;
+
+private:
+    double firstWindow;
+    double secondWindow;
+};
+
+#endif // BASELINEFILTER_H
@@ -0,0 +1,194 @@
+/*
+ * Copyright (C) 2014-2015 Daniel Gromer
+ *
+ * This file is part of PeakMan.
+ *
+ * PeakMan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * PeakMan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PeakMan.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "beatcorrector.h"
+#include "runningmedian.h"
+#include <qmath.h>
+
+// Unflagged intervals on either side of an interval for its reference
+static const int ReferenceHalf = 10;
+
+// Tolerance of a corrected interval around the reference, as fraction of it
+static const double Tolerance = 0.25;
+
+// Intervals shorter than this fraction of the reference are a beat detected twice
+static const double SplitFraction = 0.33;
+
+// Median of the unflagged intervals in a window centered on each interval,
+// the window grows over flagged intervals until it has enough of them
+static QVector<double> referenceIntervals(const QVector<double> &intervals, const QVector<bool> &flagged)
+{
+    int n = intervals.size();
+    QVector<double> reference(n);
+
+    // Unflagged intervals in order, and the number of them before each interval
+    QVector<double> normal;
+    QVector<int> before(n);
+
+    for (int i = 0; i < n; i++)
+    {
+        before[i] = normal.size();
+
+        if (!flagged[i]) normal << intervals[i];
+    }
+
+    if (normal.isEmpty())
+    {
+        reference.fill(0);
+        return reference;
+    }
+
+    RunningMedian median;
+    int lo = 0, hi = 0; // Window of normal intervals is [lo, hi)
+
+    for (int i = 0; i < n; i++)
+    {
+        int from = qMax(0, before[i] - ReferenceHalf);
+        int to = qMin(normal.size(), before[i] + ReferenceHalf + (flagged[i] ? 0 : 1));
+
+        while (hi < to) median.insert(normal[hi++]);
+        while (lo < from) median.remove(normal[lo++]);
+
+        reference[i] = median.median();
+    }
+
+    return reference;
+}
+
+BeatCorrector::Result BeatCorrector::correct(const QVector<double> &peaks, const QVector<quint8> &flags, const QVector<int> &artifacts)
+{
+    Result result;
+    result.inserted = 0;
+    result.deleted = 0;
+    result.merged = 0;
+    result.skipped = 0;
+
+    int n = peaks.size() - 1; // Intervals
+
+    if (n < 2)
+    {
+        result.peaks = peaks;
+        result.flags = flags;
+        return result;
+    }
+
+    QVector<double> intervals(n);
+    QVector<bool> flagged(n, false);
+
+    for (int i = 0; i < n; i++)
+    {
+        intervals[i] = peaks[i + 1] - peaks[i];
+    }
+
+    for (int a = 0; a < artifacts.size(); a++)
+    {
+        if (artifacts[a] >= 0 && artifacts[a] < n) flagged[artifacts[a]] = true;
+    }
+
+    QVector<double> reference = referenceIntervals(intervals, flagged);
+
+    // Peaks to keep, moved peaks of merged pairs and the new beats. The
+    // corrections are collected first and applied together at the end.
+    QVector<bool> keep(peaks.size(), true);
+    QVector<double> position = peaks;
+    QVector<quint8> flag = flags;
+    QVector<double> inserted;
+
+    for (int i = 0; i < n; i++)
+    {
+        if (!flagged[i]) continue;
+
+        double ref = reference[i];
+        double rr = intervals[i];
+
+        // The peak at the start was removed by the previous correction
+        if (ref <= 0 || !keep[i])
+        {
+            result.skipped++;
+            continue;
+        }
+
+        if (rr < SplitFraction * ref && i + 2 < peaks.size())
+        {
+            // Beat detected twice, one peak in the middle
+            position[i] = (peaks[i] + peaks[i + 1]) / 2;
+            flag[i] |= flag[i + 1];
+            keep[i + 1] = false;
+            result.merged++;
+            i++;
+        }
+        else if (rr < (1 - Tolerance) * ref && i + 1 < n && qAbs(rr + intervals[i + 1] - ref) < Tolerance * ref)
+        {
+            // Extra beat splitting a normal interval
+            keep[i + 1] = false;
+            result.deleted++;
+            i++;
+        }
+        else if (rr > (1 + Tolerance) * ref)
+        {
+            // Missing beats, evenly spaced like insertMissingPeaks()
+            int beats = qRound(rr / ref);
+
+            if (beats < 2 || qAbs(rr / beats - ref) > Tolerance * ref)
+            {
+                result.skipped++;
+                continue;
+            }
+
+            for (int k = 1; k < beats; k++)
+            {
+                inserted << peaks[i] + k * rr / beats;
+            }
+
+            result.inserted += beats - 1;
+        }
+        else
+        {
+            result.skipped++;
+        }
+    }
+
+    // Merge the kept peaks with the inserted ones, both are sorted
+    result.peaks.reserve(peaks.size() + inserted.size());
+    result.flags.reserve(peaks.size() + inserted.size());
+
+    int j = 0;
+
+    for (int i = 0; i < peaks.size(); i++)
+    {
+        if (!keep[i]) continue;
+
+        while (j < inserted.size() && inserted[j] < position[i])
+        {
+            result.peaks << inserted[j++];
+            result.flags << 0;
+        }
+
+        result.peaks << position[i];
+        result.flags << flag[i];
+    }
+
+    while (j < inserted.size())
+    {
+        result.peaks << inserted[j++];
+        result.flags << 0;
+    }
+
+    return result;
+}
@@ -0,0 +1,47 @@
+/*
+ * Copyright (C) 2014-2015 Daniel Gromer
+ *
+ * This file is part of PeakMan.
+ *
+ * PeakMan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * PeakMan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PeakMan.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BEATCORRECTOR_H
+#define BEATCORRECTOR_H
+
+#include <QVector>
+
+// Automatic correction of all artifact intervals in one pass. Each flagged
+// interval is compared with the median of the unflagged intervals around it:
+// a multiple of it gets the missing beats inserted, a beat splitting a normal
+// interval in two is deleted, and a beat detected twice is merged into one.
+// Kept peaks keep their flags (see PeakStore::Flag), a merged peak has those
+// of both peaks and inserted ones have none.
+class BeatCorrector
+{
+public:
+    struct Result
+    {
+        QVector<double> peaks; // Corrected peak positions in seconds
+        QVector<quint8> flags; // Flags of the corrected peaks
+        int inserted;
+        int deleted;
+        int merged;
+        int skipped; // Flagged intervals that fit none of the corrections
+    };
+
+    static Result correct(const QVector<double> &peaks, const QVector<quint8> &flags, const QVector<int> &artifacts); // Artifacts are interval indices, interval i ends at peak i + 1
+};
+
+#endif // BEATCORRECTOR_H
@@ -0,0 +1,234 @@
+/*
+ * Copyright (C) 2014-2015 Daniel Gromer
+ *
+ * This file is part of PeakMan.
+ *
+ * PeakMan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * PeakMan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PeakMan.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "beatfeatures.h"
+#include <QtAlgorithms>
+#include <QtConcurrentMap>
+#include <qmath.h>
+#include <algorithm>
+
+// Beats per parallel work item
+static const int ChunkBeats = 4096;
+
+// Measurement window around the R peak, in seconds
+static const double SearchBefore = 0.15;
+static const double SearchAfter = 0.15;
+
+// Isoelectric PR segment used as the local baseline
+static const double BaselineFrom = -0.15;
+static const double BaselineTo = -0.06;
+
+// Upstroke and downstroke of the QRS complex are searched this far from the R peak
+static const double SlopeRange = 0.06;
+
+// The QRS complex ends where the slope stays below this fraction of its
+// steepest slope for QuietTime seconds
+static const double SlopeFraction = 0.1;
+static const double QuietTime = 0.01;
+
+struct FeatureChunk
+{
+    const ECGSignal *signal;
+    const QVector<double> *peaks;
+    double sampleRate;
+    int first; // Rows of this chunk
+    int last;
+    double *columns[BeatFeatures::FeatureCount]; // Destination columns
+};
+
+static void measureChunk(FeatureChunk &chunk)
+{
+    double fs = chunk.sampleRate;
+    int before = qRound(SearchBefore * fs);
+    int after = qRound(SearchAfter * fs);
+    int length = before + after + 1;
+    int slopeRange = qMax(1, qRound(SlopeRange * fs));
+    int quiet = qMax(1, qRound(QuietTime * fs));
+    int n = chunk.signal->size();
+
+    QVector<double> x(length);
+    QVector<double> slope(length);
+    QVector<double> isoelectric;
+
+    for (int b = chunk.first; b < chunk.last; b++)
+    {
+        for (int f = 0; f < BeatFeatures::FeatureCount; f++) chunk.columns[f][b] = 0;
+
+        int r = qRound(chunk.peaks->at(b) * fs);
+        int from = r - before;
+
+        // Beats too close to the ends of the signal are not measured
+        if (from < 0 || from + length > n) continue;
+
+        chunk.signal->read(from, length, x.data());
+
+        // Local baseline, median of the PR segment
+        isoelectric.clear();
+
+        for (int i = before + qRound(BaselineFrom * fs); i <= before + qRound(BaselineTo * fs); i++)
+        {
+            isoelectric << x[i];
+        }
+
+        std::nth_element(isoelectric.begin(), isoelectric.begin() + isoelectric.size() / 2, isoelectric.end());
+        double baseline = isoelectric[isoelectric.size() / 2];
+
+        // Slope magnitude, and the steepest up- and downstroke next to the peak
+        slope[0] = 0;
+        slope[length - 1] = 0;
+
+        for (int i = 1; i < length - 1; i++)
+        {
+            slope[i] = qAbs(x[i + 1] - x[i - 1]) / 2;
+        }
+
+        int up = before, down = before;
+
+        for (int i = qMax(1, before - slopeRange); i < before; i++)
+        {
+            if (slope[i] > slope[up]) up = i;
+        }
+
+        for (int i = before + 1; i <= qMin(length - 2, before + slopeRange); i++)
+        {
+            if (slope[i] > slope[down]) down = i;
+        }
+
+        double threshold = SlopeFraction * qMax(slope[up], slope[down]);
+
+        // Walk outwards until the signal has been flat for a while
+        int onset = up, offset = down, run = 0;
+
+        while (onset > 0 && run < quiet)
+        {
+            onset--;
+            run = slope[onset] < threshold ? run + 1 : 0;
+        }
+
+        onset += run;
+        run = 0;
+
+        while (offset < length - 1 && run < quiet)
+        {
+            offset++;
+            run = slope[offset] < threshold ? run + 1 : 0;
+        }
+
+        offset -= run;
+
+        double area = 0;
+
+        for (int i = onset; i <= offset; i++)
+        {
+            area += x[i] - baseline;
+        }
+
+        chunk.columns[BeatFeatures::Amplitude][b] = x[before] - baseline;
+        chunk.columns[BeatFeatures::QRSWidth][b] = (offset - onset) / fs;
+        chunk.columns[BeatFeatures::Area][b] = area / fs;
+    }
+}
+
+BeatFeatures::BeatFeatures()
+{
+
+}
+
+QString BeatFeatures::name(Feature feature)
+{
+    switch (feature)
+    {
+    case Amplitude: return "amplitude";
+    case QRSWidth: return "qrs_width";
+    case Area: return "area";
+    default: return "";
+    }
+}
+
+void BeatFeatures::compute(const ECGSignal &signal, double sampleRate, const QVector<double> &peaks)
+{
+    pos = peaks;
+
+    for (int f = 0; f < FeatureCount; f++)
+    {
+        columns[f] = QVector<double>(peaks.size(), 0);
+    }
+
+    if (peaks.isEmpty() || sampleRate <= 0) return;
+
+    QVector<FeatureChunk> chunks;
+
+    for (int first = 0; first < peaks.size(); first += ChunkBeats)
+    {
+        FeatureChunk chunk;
+        chunk.signal = &signal;
+        chunk.peaks = &pos;
+        chunk.sampleRate = sampleRate;
+        chunk.first = first;
+        chunk.last = qMin(peaks.size(), first + ChunkBeats);
+
+        for (int f = 0; f < FeatureCount; f++)
+        {
+            chunk.columns[f] = columns[f].data();
+        }
+
+        chunks << chunk;
+    }
+
+    QtConcurrent::blockingMap(chunks, measureChunk);
+}
+
+void BeatFeatures::clear()
+{
+    pos.clear();
+
+    for (int f = 0; f < FeatureCount; f++)
+    {
+        columns[f].clear();
+    }
+}
+
+int BeatFeatures::size() const
+{
+    return pos.size();
+}
+
+bool BeatFeatures::isEmpty() const
+{
+    return pos.isEmpty();
+}
+
+const QVector<double> &BeatFeatures::positions() const
+{
+    return pos;
+}
+
+const QVector<double> &BeatFeatures::column(Feature feature) const
+{
+    return columns[feature];
+}
+
+int BeatFeatures::indexOf(double position) const
+{
+    QVector<double>::const_iterator it = qLowerBound(pos.constBegin(), pos.constEnd(), position);
+
+    if (it == pos.constEnd() || *it != position) return -1;
+
+    return it - pos.constBegin();
+}
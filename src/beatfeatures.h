@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2014-2015 Daniel Gromer
+ *
+ * This file is part of PeakMan.
+ *
+ * PeakMan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * PeakMan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PeakMan.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BEATFEATURES_H
+#define BEATFEATURES_H
+
+#include <QVector>
+#include <QString>
+#include "ecgsignal.h"
+
+// Table of per-beat features, stored column by column (one array per
+// feature) so a single feature can be scanned, plotted or exported without
+// touching the others. Beats are measured in parallel chunks, each writing
+// its own rows of the columns.
+class BeatFeatures
+{
+public:
+    enum Feature
+    {
+        Amplitude, // R peak above the local baseline
+        QRSWidth, // In seconds
+        Area, // Of the QRS complex above the baseline, in signal units * seconds
+        FeatureCount
+    };
+
+    BeatFeatures();
+
+    static QString name(Feature feature);
+
+    void compute(const ECGSignal &signal, double sampleRate, const QVector<double> &peaks);
+    void clear();
+
+    int size() const;
+    bool isEmpty() const;
+
+    const QVector<double> &positions() const; // Sorted, in seconds
+    const QVector<double> &column(Feature feature) const;
+    int indexOf(double position) const; // Row of a peak, -1 if not in the table
+
+private:
+    QVector<double> pos;
+    QVector<double> columns[FeatureCount];
+};
+
+#endif // BEATFEATURES_H
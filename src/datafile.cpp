@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2014-2015 Daniel Gromer
+ *
+ * This file is part of PeakMan.
+ *
+ * PeakMan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * PeakMan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PeakMan.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "datafile.h"
+#include <QFile>
+#include <string.h>
+
+// Bytes read from the file at once
+static const int ChunkSize = 1048576;
+
+ECGSignal DataFile::readSignal(const QString &fileName)
+{
+    ECGSignal signal;
+
+    if (parse(fileName, &signal, 0))
+    {
+        // Convert to int16 storage if the file contains adc counts
+        signal.squeeze();
+    }
+    else
+    {
+        signal.clear();
+    }
+
+    return signal;
+}
+
+QVector<double> DataFile::readValues(const QString &fileName)
+{
+    QVector<double> values;
+
+    if (!parse(fileName, 0, &values))
+    {
+        values.clear();
+    }
+
+    return values;
+}
+
+bool DataFile::parse(const QString &fileName, ECGSignal *signal, QVector<double> *values)
+{
+    QFile file(fileName);
+
+    if (!file.open(QIODevice::ReadOnly)) return false;
+
+    QByteArray buffer;
+
+    // Read the file in chunks and parse the lines in place, which is much
+    // faster than QTextStream::readLine()
+    while (!file.atEnd())
+    {
+        buffer += file.read(ChunkSize);
+
+        const char *begin = buffer.constData();
+        const char *end = begin + buffer.size();
+
+        while (const char *lineEnd = (const char*) memchr(begin, '\n', end - begin))
+        {
+            parseLine(begin, lineEnd, signal, values);
+            begin = lineEnd + 1;
+        }
+
+        // Keep the incomplete last line for the next chunk
+        buffer.remove(0, begin - buffer.constData());
+    }
+
+    // Last line without line break
+    if (!buffer.trimmed().isEmpty())
+    {
+        parseLine(buffer.constData(), buffer.constData() + buffer.size(), signal, values);
+    }
+
+    file.close();
+
+    return true;
+}
+
+void DataFile::parseLine(const char *begin, const char *end, ECGSignal *signal, QVector<double> *values)
+{
+    QByteArray line = QByteArray::fromRawData(begin, end - begin).trimmed();
+
+    bool ok;
+    double value = line.toDouble(&ok);
+
+    if (signal)
+    {
+        // Same as before for the ecg signal: unreadable samples and empty
+        // lines become zero, so the following samples keep their time
+        signal->append(value);
+    }
+    else if (ok)
+    {
+        *values << value;
+    }
+}
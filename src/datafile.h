@@ -0,0 +1,41 @@
+/*
+ * Copyright (C) 2014-2015 Daniel Gromer
+ *
+ * This file is part of PeakMan.
+ *
+ * PeakMan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * PeakMan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PeakMan.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DATAFILE_H
+#define DATAFILE_H
+
+#include <QString>
+#include <QVector>
+#include "ecgsignal.h"
+
+// Readers for the text files PeakMan works with (one value per line). Files
+// are parsed in chunks, so they can be used from worker threads and for
+// recordings that do not fit into memory.
+class DataFile
+{
+public:
+    static ECGSignal readSignal(const QString &fileName);
+    static QVector<double> readValues(const QString &fileName);
+
+private:
+    static bool parse(const QString &fileName, ECGSignal *signal, QVector<double> *values);
+    static void parseLine(const char *begin, const char *end, ECGSignal *signal, QVector<double> *values);
+};
+
+#endif // DATAFILE_H
@@ -0,0 +1,360 @@
+/*
+ * Copyright (C) 2014-2015 Daniel Gromer
+ *
+ * This file is part of PeakMan.
+ *
+ * PeakMan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * PeakMan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PeakMan.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ecgfilter.h"
+#include <QThread>
+#include <QtConcurrentMap>
+#include <qmath.h>
+
+// Chunks filtered together in one group, interleaved so that the biquad
+// recursion of all lanes can run in the same (vectorizable) inner loop
+static const int Lanes = 4;
+
+// Samples per chunk, without warm-up
+static const int ChunkSize = 65536;
+
+struct FilterGroup
+{
+    const ECGSignal *signal;
+    QVector<ECGFilter::Biquad> sections;
+    int start[Lanes]; // First sample of each chunk, -1 if unused
+    int warmUp;
+    QVector<double> data; // Interleaved samples, data[n * Lanes + lane]
+};
+
+// Read samples, reflecting the signal at both ends where the range exceeds it
+static void readPadded(const ECGSignal *signal, int from, int count, double *out)
+{
+    int n = signal->size();
+    int first = qMax(from, 0);
+    int last = qMin(from + count, n);
+
+    if (last > first)
+    {
+        signal->read(first, last - first, out + (first - from));
+    }
+
+    for (int i = from; i < first; i++)
+    {
+        int mirror = qMin(-i, n - 1);
+        out[i - from] = 2 * signal->at(0) - signal->at(mirror);
+    }
+
+    for (int i = qMax(last, from); i < from + count; i++)
+    {
+        int mirror = qMax(2 * (n - 1) - i, 0);
+        out[i - from] = 2 * signal->at(n - 1) - signal->at(mirror);
+    }
+}
+
+static void filterGroup(FilterGroup &group)
+{
+    int length = ChunkSize + 2 * group.warmUp;
+
+    group.data = QVector<double>(length * Lanes, 0);
+
+    // Interleave the chunks
+    QVector<double> buffer(length);
+
+    for (int lane = 0; lane < Lanes; lane++)
+    {
+        if (group.start[lane] < 0) continue;
+
+        readPadded(group.signal, group.start[lane] - group.warmUp, length, buffer.data());
+
+        for (int n = 0; n < length; n++)
+        {
+            group.data[n * Lanes + lane] = buffer[n];
+        }
+    }
+
+    double *data = group.data.data();
+
+    for (int s = 0; s < group.sections.size(); s++)
+    {
+        const ECGFilter::Biquad &q = group.sections[s];
+        double z1[Lanes], z2[Lanes];
+
+        // Forward pass (transposed direct form II)
+        for (int lane = 0; lane < Lanes; lane++)
+        {
+            z1[lane] = 0;
+            z2[lane] = 0;
+        }
+
+        for (int n = 0; n < length; n++)
+        {
+            double *x = data + n * Lanes;
+
+            for (int lane = 0; lane < Lanes; lane++)
+            {
+                double y = q.b0 * x[lane] + z1[lane];
+                z1[lane] = q.b1 * x[lane] - q.a1 * y + z2[lane];
+                z2[lane] = q.b2 * x[lane] - q.a2 * y;
+                x[lane] = y;
+            }
+        }
+
+        // Backward pass, cancels the phase shift of the forward pass
+        for (int lane = 0; lane < Lanes; lane++)
+        {
+            z1[lane] = 0;
+            z2[lane] = 0;
+        }
+
+        for (int n = length - 1; n >= 0; n--)
+        {
+            double *x = data + n * Lanes;
+
+            for (int lane = 0; lane < Lanes; lane++)
+            {
+                double y = q.b0 * x[lane] + z1[lane];
+                z1[lane] = q.b1 * x[lane] - q.a1 * y + z2[lane];
+                z2[lane] = q.b2 * x[lane] - q.a2 * y;
+                x[lane] = y;
+            }
+        }
+    }
+}
+
+ECGFilter::ECGFilter()
+{
+    highPass = 0;
+    lowPass = 0;
+    notch = 0;
+}
+
+void ECGFilter::setHighPass(double frequency)
+{
+    highPass = frequency;
+}
+
+void ECGFilter::setLowPass(double frequency)
+{
+    lowPass = frequency;
+}
+
+void ECGFilter::setNotch(double frequency)
+{
+    notch = frequency;
+}
+
+double ECGFilter::getHighPass() const
+{
+    return highPass;
+}
+
+double ECGFilter::getLowPass() const
+{
+    return lowPass;
+}
+
+double ECGFilter::getNotch() const
+{
+    return notch;
+}
+
+bool ECGFilter::isEnabled() const
+{
+    return highPass > 0 || lowPass > 0 || notch > 0;
+}
+
+ECGSignal ECGFilter::apply(const ECGSignal &signal, double sampleRate) const
+{
+    ECGSignal filtered;
+
+    QVector<Biquad> sections = design(sampleRate);
+
+    if (signal.isEmpty() || sections.isEmpty()) return signal;
+
+    int n = signal.size();
+    int chunks = (n + ChunkSize - 1) / ChunkSize;
+
+    // Groups running at the same time, bounds the memory in use
+    int batchSize = qMax(1, QThread::idealThreadCount());
+
+    for (int firstChunk = 0; firstChunk < chunks; firstChunk += batchSize * Lanes)
+    {
+        QVector<FilterGroup> groups;
+
+        for (int c = firstChunk; c < qMin(chunks, firstChunk + batchSize * Lanes); c += Lanes)
+        {
+            FilterGroup group;
+            group.signal = &signal;
+            group.sections = sections;
+            group.warmUp = warmUp(sampleRate);
+
+            for (int lane = 0; lane < Lanes; lane++)
+            {
+                group.start[lane] = c + lane < chunks ? (c + lane) * ChunkSize : -1;
+            }
+
+            groups << group;
+        }
+
+        QtConcurrent::blockingMap(groups, filterGroup);
+
+        // Collect the chunks in order, without their warm-up
+        for (int g = 0; g < groups.size(); g++)
+        {
+            for (int lane = 0; lane < Lanes && groups[g].start[lane] >= 0; lane++)
+            {
+                int count = qMin(ChunkSize, n - groups[g].start[lane]);
+                const double *data = groups[g].data.constData() + groups[g].warmUp * Lanes + lane;
+
+                for (int i = 0; i < count; i++)
+                {
+                    filtered.append(data[i * Lanes]);
+                }
+            }
+
+            groups[g].data.clear();
+        }
+    }
+
+    filtered.squeeze();
+
+    return filtered;
+}
+
+void ECGFilter::apply(double *data, int count, double sampleRate) const
+{
+    QVector<Biquad> sections = design(sampleRate);
+
+    if (count < 2 || sections.isEmpty()) return;
+
+    // Same reflection at both ends as for ecg signals
+    int pad = warmUp(sampleRate);
+    QVector<double> buffer(count + 2 * pad);
+
+    for (int i = -pad; i < count + pad; i++)
+    {
+        int j = i;
+
+        if (i < 0) j = qMin(-i, count - 1);
+        if (i >= count) j = qMax(2 * (count - 1) - i, 0);
+
+        double value = data[j];
+
+        if (i < 0) value = 2 * data[0] - value;
+        if (i >= count) value = 2 * data[count - 1] - value;
+
+        buffer[i + pad] = value;
+    }
+
+    double *x = buffer.data();
+    int length = buffer.size();
+
+    for (int s = 0; s < sections.size(); s++)
+    {
+        const Biquad &q = sections[s];
+        double z1 = 0, z2 = 0;
+
+        for (int n = 0; n < length; n++)
+        {
+            double y = q.b0 * x[n] + z1;
+            z1 = q.b1 * x[n] - q.a1 * y + z2;
+            z2 = q.b2 * x[n] - q.a2 * y;
+            x[n] = y;
+        }
+
+        z1 = 0;
+        z2 = 0;
+
+        for (int n = length - 1; n >= 0; n--)
+        {
+            double y = q.b0 * x[n] + z1;
+            z1 = q.b1 * x[n] - q.a1 * y + z2;
+            z2 = q.b2 * x[n] - q.a2 * y;
+            x[n] = y;
+        }
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        data[i] = x[i + pad];
+    }
+}
+
+QVector<ECGFilter::Biquad> ECGFilter::design(double sampleRate) const
+{
+    // Biquad coefficients from the Audio EQ Cookbook (R. Bristow-Johnson),
+    // Butterworth response for high-pass and low-pass
+    QVector<Biquad> sections;
+    double nyquist = sampleRate / 2;
+
+    for (int type = 0; type < 3; type++)
+    {
+        double f0 = type == 0 ? highPass : type == 1 ? lowPass : notch;
+        double Q = type == 2 ? 30 : M_SQRT1_2;
+
+        if (f0 <= 0 || f0 >= 0.95 * nyquist) continue;
+
+        double w0 = 2 * M_PI * f0 / sampleRate;
+        double c = qCos(w0);
+        double alpha = qSin(w0) / (2 * Q);
+        double a0 = 1 + alpha;
+
+        Biquad q;
+
+        if (type == 0)
+        {
+            q.b0 = (1 + c) / 2;
+            q.b1 = -(1 + c);
+            q.b2 = (1 + c) / 2;
+        }
+        else if (type == 1)
+        {
+            q.b0 = (1 - c) / 2;
+            q.b1 = 1 - c;
+            q.b2 = (1 - c) / 2;
+        }
+        else
+        {
+            q.b0 = 1;
+            q.b1 = -2 * c;
+            q.b2 = 1;
+        }
+
+        q.b0 /= a0;
+        q.b1 /= a0;
+        q.b2 /= a0;
+        q.a1 = -2 * c / a0;
+        q.a2 = (1 - alpha) / a0;
+
+        sections << q;
+    }
+
+    return sections;
+}
+
+int ECGFilter::warmUp(double sampleRate) const
+{
+    // Several time constants of the slowest stage, after that the transient
+    // of a chunk start has decayed below anything visible
+    double slowest = 0;
+
+    if (highPass > 0) slowest = highPass;
+    if (lowPass > 0 && (slowest == 0 || lowPass < slowest)) slowest = lowPass;
+    if (notch > 0 && (slowest == 0 || notch / 30 < slowest)) slowest = notch / 30;
+
+    if (slowest == 0) return 0;
+
+    return qMin(qCeil(4 * sampleRate / slowest), qCeil(60 * sampleRate));
+}
@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2014-2015 Daniel Gromer
+ *
+ * This file is part of PeakMan.
+ *
+ * PeakMan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * PeakMan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PeakMan.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ECGFILTER_H
+#define ECGFILTER_H
+
+#include <QVector>
+#include "ecgsignal.h"
+
+// Zero-phase band-pass (and optional notch) filter for ecg signals, made of
+// cascaded biquads that run forward and backward. The signal is filtered in
+// parallel chunks, each extended by a warm-up overlap on both sides.
+class ECGFilter
+{
+public:
+    ECGFilter();
+
+    void setHighPass(double frequency); // 0 disables the stage
+    void setLowPass(double frequency);
+    void setNotch(double frequency);
+
+    double getHighPass() const;
+    double getLowPass() const;
+    double getNotch() const;
+    bool isEnabled() const;
+
+    ECGSignal apply(const ECGSignal &signal, double sampleRate) const;
+    void apply(double *data, int count, double sampleRate) const; // Short series in place, single-threaded
+    int warmUp(double sampleRate) const; // Samples until the transient of an edge has decayed
+
+    struct Biquad
+    {
+        double b0, b1, b2, a1, a2;
+    };
+
+private:
+    QVector<Biquad> design(double sampleRate) const;
+
+    double highPass;
+    double lowPass;
+    double notch;
+};
+
+#endif // ECGFILTER_H
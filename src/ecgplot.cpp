@@ -18,6 +18,7 @@
  */
 
 #include "ecgplot.h"
+#include <algorithm>
 
 ECGPlot::ECGPlot(QWidget *parent) : QCustomPlot(parent)
 {
@@ -26,11 +27,52 @@ ECGPlot::ECGPlot(QWidget *parent) : QCustomPlot(parent)
     // Initialize rubberband
     rubberBand = 0;
 
+    sampleRate = 0;
+
     // Initialize layers
+    addLayer("quality", layer("main"), QCustomPlot::limBelow);
     addLayer("peaks");
     addLayer("globalthresholdline");
     addLayer("highlight");
 
+    // Ecg signal, drawn directly from the compact sample storage
+    ecg = new SignalGraph(xAxis, yAxis);
+    addPlottable(ecg);
+    ecg->setPen(QPen(QColor(77, 77, 76)));
+
+    // Baseline overlay
+    baselineGraph = new SignalGraph(xAxis, yAxis);
+    addPlottable(baselineGraph);
+    baselineGraph->setPen(QPen(QColor(200, 40, 41), 2));
+    baselineVisible = false;
+
+    // Heart rate overlay, on its own axis. A few samples per second, so the
+    // values are plotted directly and edits replace just the changed ones.
+    heartRateGraph = new QCPGraph(xAxis, yAxis2);
+    addPlottable(heartRateGraph);
+    heartRateGraph->setPen(QPen(QColor(62, 153, 159), 2));
+    heartRateVisible = false;
+    yAxis2->setLabel("Heart rate (bpm)");
+
+    // Shading of unusable segments, below the signal
+    qualityShading = new QualityShading(xAxis, yAxis);
+    addPlottable(qualityShading);
+    qualityShading->setLayer("quality");
+    qualityShading->setSegments(&unusableSegments, 0);
+    qualityShading->setBrush(QBrush(QColor(200, 40, 41, 40)));
+    segmentDuration = 0;
+    skipUnusableSegments = false;
+
+    // Peaks, drawn from the peak store
+    peakMarkers = new PeakMarkers(xAxis, yAxis);
+    addPlottable(peakMarkers);
+    peakMarkers->setLayer("peaks");
+    peakMarkers->setPeaks(&peaks);
+    peakMarkers->setPen(QPen(QBrush(QColor(66, 113, 174, 130)), 5));
+    peakMarkers->setSelectedPen(QPen(QBrush(QColor(234, 183, 0, 200)), 3));
+    peakMarkers->setEctopicPen(QPen(QBrush(QColor(200, 40, 41, 160)), 5));
+    colorFeature = -1;
+
     // Set axis labels
     xAxis->setLabel("Time (s)");
     yAxis->setLabel("Voltage (mV)");
@@ -72,24 +114,141 @@ ECGPlot::~ECGPlot()
 
 }
 
-void ECGPlot::plot(QVector<double> x, QVector<double> y)
+void ECGPlot::plot(const ECGSignal &signal)
 {
-    // Store ecg signal in vectors
-    ecg_x = x;
-    ecg_y = y;
+    // Store ecg signal (samples are implicitly shared, no copy here)
+    this->signal = signal;
+    filtered.clear();
+    baseline.clear();
 
-    ecg = addGraph();
-    ecg->setPen(QPen(QColor(77, 77, 76)));
-    ecg->setData(x, y);
+    updateGraphs();
+    replot();
+}
+
+void ECGPlot::setFilteredSignal(const ECGSignal &filtered)
+{
+    this->filtered = filtered;
+
+    updateGraphs();
     replot();
+
+    emit peaksReset();
+}
+
+void ECGPlot::setBaseline(const ECGSignal &baseline)
+{
+    this->baseline = baseline;
+
+    updateGraphs();
+    replot();
+}
+
+void ECGPlot::invertSignal()
+{
+    // Filters and baseline estimation are linear (or commute with negation),
+    // so the derived signals are flipped as well instead of recomputed
+    signal.invert();
+    filtered.invert();
+    baseline.invert();
+
+    updateGraphs();
+    replot();
+
+    emit peaksReset();
+}
+
+void ECGPlot::setHeartRate(const QVector<double> &bpm, double rate)
+{
+    if (bpm.isEmpty())
+    {
+        heartRateGraph->clearData();
+    }
+    else
+    {
+        QVector<double> time(bpm.size());
+
+        for (int k = 0; k < bpm.size(); k++)
+        {
+            time[k] = k / rate;
+        }
+
+        heartRateGraph->setData(time, bpm);
+
+        double minimum = *std::min_element(bpm.constBegin(), bpm.constEnd());
+        double maximum = *std::max_element(bpm.constBegin(), bpm.constEnd());
+        yAxis2->setRange(minimum - 10, maximum + 10);
+    }
+
+    heartRateGraph->setVisible(heartRateVisible);
+    yAxis2->setVisible(heartRateVisible && !bpm.isEmpty());
+
+    replot();
+}
+
+void ECGPlot::updateHeartRate(const QVector<double> &bpm, double rate, int from, int to)
+{
+    // Nothing to update, or nothing left
+    if (bpm.isEmpty() || heartRateGraph->data()->isEmpty())
+    {
+        setHeartRate(bpm, rate);
+        return;
+    }
+
+    // Same keys as in setHeartRate(), so the samples are replaced
+    QCPDataMap *data = heartRateGraph->data();
+
+    for (int k = from; k < to; k++)
+    {
+        (*data)[k / rate] = QCPData(k / rate, bpm[k]);
+    }
+}
+
+void ECGPlot::setHeartRateVisible(bool visible)
+{
+    heartRateVisible = visible;
+
+    heartRateGraph->setVisible(visible);
+    yAxis2->setVisible(visible && !heartRateGraph->data()->isEmpty());
+
+    replot();
+}
+
+void ECGPlot::setBaselineVisible(bool visible)
+{
+    baselineVisible = visible;
+
+    updateGraphs();
+    replot();
+}
+
+void ECGPlot::updateGraphs()
+{
+    if (baselineVisible && !baseline.isEmpty())
+    {
+        // Show the baseline on top of the signal it was estimated from
+        ecg->setSignal(&signal, sampleRate);
+        baselineGraph->setSignal(&baseline, sampleRate);
+    }
+    else
+    {
+        ecg->setSignal(&activeSignal(), sampleRate);
+        baselineGraph->clearData();
+    }
 }
 
 void ECGPlot::clear()
 {
     // Remove ecg signal
-    removeGraph(ecg);
-    ecg_x.clear();
-    ecg_y.clear();
+    ecg->clearData();
+    baselineGraph->clearData();
+    heartRateGraph->clearData();
+    signal.clear();
+    filtered.clear();
+    baseline.clear();
+    yAxis2->setVisible(false);
+
+    // Remove signal quality
+    setSegmentDuration(0);
 
     // Remove peaks
     clearPeaks();
@@ -102,18 +261,35 @@ void ECGPlot::peakdet(double local_threshold, double global_threshold, double mi
     // Remove already detected peaks
     clearPeaks();
 
+    // Detection runs on the filtered signal if there is one
+    const ECGSignal &source = activeSignal();
+
+    if (source.isEmpty()) return;
+
     // Peak detection algorithm starts here
-    double mn = ecg_y.first(), mx = ecg_y.first(), mxpos = ecg_x.first(), curr;
+    double mn = source.at(0), mx = source.at(0), mxpos = 0, curr;
     bool lookformax = true;
 
-    for (int i = 0; i < ecg_y.size(); i++)
+    // Samples are decoded block by block from the compact storage
+    const int blockSize = 4096;
+    QVector<double> block(blockSize);
+
+    // Detected peaks are collected in order and stored at once
+    QVector<double> detected;
+
+    for (int i = 0; i < source.size(); i++)
     {
-        curr = ecg_y[i];
+        if (i % blockSize == 0)
+        {
+            source.read(i, qMin(blockSize, source.size() - i), block.data());
+        }
+
+        curr = block[i % blockSize];
 
         if (curr > mx)
         {
             mx = curr;
-            mxpos = ecg_x[i];
+            mxpos = (double) i / sampleRate;
         }
 
         if (curr < mn)
@@ -126,9 +302,10 @@ void ECGPlot::peakdet(double local_threshold, double global_threshold, double mi
             if (curr < mx - local_threshold)
             {
                 // Check for global threshold and minimal RR interval
-                if (mx > global_threshold && !(peaks.size() > 1 && !((mxpos - peaks.last()->point1->key()) > minrrinterval / 1000)))
+                if (mx > global_threshold && !(detected.size() > 1 && !((mxpos - detected.last()) > minrrinterval / 1000))
+                        && (!skipUnusableSegments || isUsable(mxpos)))
                 {
-                    peaks.append(insertNewPeak(mxpos));
+                    detected << mxpos;
                 }
 
                 mn = curr;
@@ -140,30 +317,108 @@ void ECGPlot::peakdet(double local_threshold, double global_threshold, double mi
             if (curr > mn + local_threshold)
             {
                 mx = curr;
-                mxpos = ecg_x[i];
+                mxpos = (double) i / sampleRate;
                 lookformax = true;
             }
         }
     }
 
+    peaks.setPositions(detected);
+
     replot();
+
+    emit peaksReset();
 }
 
-QCPItemStraightLine* ECGPlot::insertNewPeak(double position)
+int ECGPlot::matchTemplate(const TemplateMatcher &matcher)
 {
-    QCPItemStraightLine* newPeak = new QCPItemStraightLine(this);
+    if (peaks.isEmpty()) return 0;
+
+    TemplateMatcher::Result result = matcher.apply(activeSignal(), sampleRate, peaks.positions());
+
+    // Refined beats move by a few samples at most, so they are usually still
+    // in order. Beats that ended up on the same sample are merged.
+    QVector<QPair<double, bool> > beats(result.positions.size());
+    bool sorted = true;
 
-    addItem(newPeak);
-    newPeak->setLayer("peaks");
+    for (int i = 0; i < beats.size(); i++)
+    {
+        beats[i] = qMakePair(result.positions[i], (bool) result.ectopic[i]);
+
+        if (i > 0 && beats[i].first < beats[i - 1].first) sorted = false;
+    }
+
+    if (!sorted)
+    {
+        qSort(beats.begin(), beats.end());
+    }
+
+    QVector<double> positions;
+    QVector<bool> ectopic;
+
+    for (int i = 0; i < beats.size(); i++)
+    {
+        if (!positions.isEmpty() && beats[i].first == positions.last())
+        {
+            // Keep the ectopic flag if either of the merged beats had it
+            ectopic.last() = ectopic.last() || beats[i].second;
+            continue;
+        }
+
+        positions << beats[i].first;
+        ectopic << beats[i].second;
+    }
 
-    // Set coordinates
-    newPeak->point1->setCoords(position, 1);
-    newPeak->point2->setCoords(position, 0);
+    peaks.setPositions(positions);
 
-    newPeak->setPen(QPen(QBrush(QColor(66, 113, 174, 130)), 5));
-    newPeak->setSelectedPen(QPen(QBrush(QColor(234, 183, 0, 200)), 3));
+    for (int i = 0; i < ectopic.size(); i++)
+    {
+        if (ectopic[i]) peaks.setEctopic(i, true);
+    }
+
+    replot();
 
-    return newPeak;
+    emit peaksReset();
+
+    return peaks.ectopicCount();
+}
+
+BeatFeatures ECGPlot::measureBeats() const
+{
+    BeatFeatures table;
+    table.compute(activeSignal(), sampleRate, peaks.positions());
+
+    return table;
+}
+
+void ECGPlot::updateBeatFeatures()
+{
+    if (colorFeature < 0 || peaks.isEmpty())
+    {
+        features.clear();
+        peakMarkers->setFeatureColors(0, -1, QCPRange());
+        replot();
+        return;
+    }
+
+    features = measureBeats();
+
+    // Color range from the 5th to the 95th percentile, so a few outliers
+    // don't squeeze all other beats into one color
+    QVector<double> values = features.column((BeatFeatures::Feature) colorFeature);
+    qSort(values.begin(), values.end());
+
+    QCPRange range(values[(int) (0.05 * (values.size() - 1))], values[(int) (0.95 * (values.size() - 1))]);
+
+    peakMarkers->setFeatureColors(&features, colorFeature, range);
+    replot();
+}
+
+void ECGPlot::setPeakColorFeature(int feature)
+{
+    colorFeature = feature;
+
+    updateBeatFeatures();
 }
 
 void ECGPlot::insertPeakAtClickPos(QPoint position)
@@ -172,31 +427,28 @@ void ECGPlot::insertPeakAtClickPos(QPoint position)
     double pos_x = xAxis->pixelToCoord((double) position.x());
 
     // Cancel if click was outside of graph
-    if (pos_x < ecg_x.first() || pos_x > ecg_x.last()) return;
+    if (signal.isEmpty() || pos_x < 0 || pos_x > getDuration()) return;
 
     int newpos = pos_x * sampleRate;
 
     // Search for maximum around clicked position
-    for (int i = (int) ((pos_x - .1) * sampleRate); i < (int) ((pos_x + .1) * sampleRate); i++)
+    const ECGSignal &source = activeSignal();
+    int from = qMax(0, (int) ((pos_x - .1) * sampleRate));
+    int to = qMin(source.size(), (int) ((pos_x + .1) * sampleRate));
+
+    for (int i = from; i < to; i++)
     {
-        if (ecg_y[i] > ecg_y[newpos]) newpos = i;
+        if (source.at(i) > source.at(newpos)) newpos = i;
     }
 
     double insert = (double)newpos / (double)sampleRate;
 
-    QLinkedList<QCPItemStraightLine*>::iterator iter;
-
-    // Search through peaks list for insertion point
-    for(iter = peaks.begin(); iter != peaks.end(); iter++)
-    {
-        if ((*iter)->point1->key() > insert)
-        {
-            QCPItemStraightLine* newPeak = insertNewPeak(insert);
-            peaks.insert(iter, newPeak);
+    PeakEdit edit = peaks.beginEdit(insert, insert);
+    peaks.insert(insert);
+    peaks.endEdit(edit);
+    replot();
 
-            return;
-        }
-    }
+    emit peaksEdited(edit);
 }
 
 void ECGPlot::insertPeakAtTimePoint(double position)
@@ -204,57 +456,135 @@ void ECGPlot::insertPeakAtTimePoint(double position)
     // Set x position to fit with samplerate
     double insert = qRound(position * (double)sampleRate) / (double)sampleRate;
 
-    QLinkedList<QCPItemStraightLine*>::iterator iter;
+    PeakEdit edit = peaks.beginEdit(insert, insert);
+    peaks.insert(insert);
+    peaks.endEdit(edit);
 
-    // Search through peaks list for insertion point
-    for(iter = peaks.begin(); iter != peaks.end(); iter++)
+    emit peaksEdited(edit);
+}
+
+int ECGPlot::insertPeaksFromVector(QVector<double> peaks_pos)
+{
+    double duration = getDuration();
+    bool sorted = true;
+    int n = 0;
+
+    // Snap peaks to sample positions and drop those outside of the ecg signal
+    for (int i = 0; i < peaks_pos.size(); i++)
     {
-        if ((*iter)->point1->key() > insert)
-        {
-            QCPItemStraightLine* newPeak = insertNewPeak(insert);
-            peaks.insert(iter, newPeak);
+        double position = peaks_pos[i];
+
+        if (!(position >= 0 && position <= duration)) continue;
+
+        position = qRound(position * (double)sampleRate) / (double)sampleRate;
 
-            return;
+        if (n > 0 && position < peaks_pos[n - 1]) sorted = false;
+
+        peaks_pos[n++] = position;
+    }
+
+    int rejected = peaks_pos.size() - n;
+    peaks_pos.resize(n);
+
+    // Files written by PeakMan are sorted already, so this is the exception
+    if (!sorted)
+    {
+        qSort(peaks_pos.begin(), peaks_pos.end());
+    }
+
+    // Remove duplicates
+    n = 0;
+
+    for (int i = 0; i < peaks_pos.size(); i++)
+    {
+        if (n == 0 || peaks_pos[i] != peaks_pos[n - 1])
+        {
+            peaks_pos[n++] = peaks_pos[i];
         }
     }
+
+    peaks_pos.resize(n);
+
+    peaks.setPositions(peaks_pos);
+
+    replot();
+
+    emit peaksReset();
+
+    return rejected;
 }
 
-void ECGPlot::insertPeaksFromVector(QVector<double> peaks_pos)
+void ECGPlot::replacePeaks(const QVector<double> &positions, const QVector<quint8> &flags)
 {
-    for(int i = 0; i < peaks_pos.size(); i++)
+    QVector<double> snapped;
+    QVector<quint8> snappedFlags;
+    snapped.reserve(positions.size());
+    snappedFlags.reserve(positions.size());
+
+    // Snap peaks to sample positions, this keeps them sorted. Peaks snapped
+    // to the same sample become one with the flags of both.
+    for (int i = 0; i < positions.size(); i++)
     {
-        peaks.append(insertNewPeak(peaks_pos[i]));
+        double position = qRound(positions[i] * (double)sampleRate) / (double)sampleRate;
+
+        if (!snapped.isEmpty() && position == snapped.last())
+        {
+            snappedFlags.last() |= flags[i];
+            continue;
+        }
+
+        snapped << position;
+        snappedFlags << flags[i];
     }
 
+    peaks.setPositions(snapped, snappedFlags);
+
     replot();
+
+    emit peaksReset();
 }
 
-void ECGPlot::deletePeak(QCPAbstractItem *peak)
+void ECGPlot::deletePeak(int index)
 {
-    peaks.removeOne(qobject_cast<QCPItemStraightLine*>(peak));
-    removeItem(peak);
+    double position = peaks.at(index);
+
+    PeakEdit edit = peaks.beginEdit(position, position);
+    peaks.remove(index);
+    peaks.endEdit(edit);
     replot();
+
+    emit peaksEdited(edit);
 }
 
-void ECGPlot::deletePeaks(QList<QCPAbstractItem *> peaksToDelete)
+void ECGPlot::deleteSelectedPeaks()
 {
-    foreach(QCPAbstractItem* peak, peaksToDelete)
+    // Range of the selection, unselected peaks within it stay
+    double from = -1, to = -1;
+
+    for (int i = 0; i < peaks.size(); i++)
     {
-        peaks.removeOne(qobject_cast<QCPItemStraightLine*>(peak));
-        removeItem(peak);
+        if (!peaks.isSelected(i)) continue;
+
+        if (from < 0) from = peaks.at(i);
+        to = peaks.at(i);
     }
 
+    if (from < 0) return;
+
+    PeakEdit edit = peaks.beginEdit(from, to);
+    peaks.removeSelected();
+    peaks.endEdit(edit);
     replot();
+
+    emit peaksEdited(edit);
 }
 
 void ECGPlot::clearPeaks()
 {
-    foreach (QCPLayerable *l, layer("peaks")->children())
-    {
-        removeItem(qobject_cast<QCPAbstractItem*>(l));
-    }
-
     peaks.clear();
+    features.clear();
+
+    emit peaksReset();
 }
 
 void ECGPlot::showIbiHighlightRect(double x, double width)
@@ -271,24 +601,34 @@ void ECGPlot::showIbiHighlightRect(double x, double width)
     replot();
 }
 
-QVector<double> ECGPlot::getEcg_x()
+const ECGSignal &ECGPlot::getSignal() const
 {
-    return ecg_x;
+    return signal;
 }
 
-QVector<double> ECGPlot::getEcg_y()
+const ECGSignal &ECGPlot::activeSignal() const
 {
-    return ecg_y;
+    return filtered.isEmpty() ? signal : filtered;
 }
 
-QLinkedList<QCPItemStraightLine *> ECGPlot::getPeaks()
+const ECGSignal &ECGPlot::getFilteredSignal() const
+{
+    return filtered;
+}
+
+double ECGPlot::getDuration() const
+{
+    return signal.isEmpty() ? 0 : (double) (signal.size() - 1) / sampleRate;
+}
+
+const PeakStore &ECGPlot::getPeaks() const
 {
     return peaks;
 }
 
 double ECGPlot::getTimeBeforeFirstPeak()
 {
-    return peaks.first()->point1->key();
+    return peaks.first();
 }
 
 void ECGPlot::updateGlobalThresholdLine(int y)
@@ -331,7 +671,7 @@ void ECGPlot::mousePressEvent(QMouseEvent *event)
     QCustomPlot::mousePressEvent(event);
 
     // Check if global threshold line is selected together with peaks
-    if (selectedItems().contains(globalThresholdLine) && selectedItems().size() > 1)
+    if (globalThresholdLine->selected() && peaks.selectedCount() > 0)
     {
         // If so, remove global threshold line from selection
         globalThresholdLine->setSelected(false);
@@ -363,24 +703,28 @@ void ECGPlot::mouseReleaseEvent(QMouseEvent *event)
         if (!(event->modifiers() == Qt::ControlModifier))
         {
             deselectAll();
+            peaks.clearSelection();
         }
 
-        double x1, x2;
-
-        x1 = qMin(xAxis->pixelToCoord((double) origin.x()), xAxis->pixelToCoord((double) event->x()));
-        x2 = qMax(xAxis->pixelToCoord((double) origin.x()), xAxis->pixelToCoord((double) event->x()));
-
-        QCPItemStraightLine *lineItem;
-
-        for (int i = 0; i < itemCount(); i++)
+        if (qAbs(event->x() - origin.x()) < 3)
         {
-            lineItem = qobject_cast<QCPItemStraightLine*>(item(i));
+            // Single click, select the peak under the cursor
+            int index = peakAt(event->pos());
 
-            if (lineItem->point1->key() >= x1 && lineItem->point1->key() <= x2)
+            if (index != -1)
             {
-                lineItem->setSelected(true);
+                peaks.setSelected(index, true);
             }
         }
+        else
+        {
+            double x1, x2;
+
+            x1 = qMin(xAxis->pixelToCoord((double) origin.x()), xAxis->pixelToCoord((double) event->x()));
+            x2 = qMax(xAxis->pixelToCoord((double) origin.x()), xAxis->pixelToCoord((double) event->x()));
+
+            peaks.selectRange(x1, x2);
+        }
 
         replot();
     }
@@ -430,10 +774,12 @@ void ECGPlot::mouseDoubleClickEvent(QMouseEvent *event)
 {
     if (event->button() == Qt::RightButton) return;
 
-    if (itemAt(event->pos()))
+    int index = peakAt(event->pos());
+
+    if (index != -1)
     {
         //emit deletePeak(itemAt(event->pos()));
-        deletePeak(itemAt(event->pos()));
+        deletePeak(index);
     }
     else
     {
@@ -448,10 +794,10 @@ void ECGPlot::mouseDoubleClickEvent(QMouseEvent *event)
 
 void ECGPlot::keyPressEvent(QKeyEvent *event)
 {
-    if (event->key() == Qt::Key_Delete && !selectedItems().isEmpty())
+    if (event->key() == Qt::Key_Delete && peaks.selectedCount() > 0)
     {
         //emit deletePeaks(selectedItems());
-        deletePeaks(selectedItems());
+        deleteSelectedPeaks();
 
         emit peaksChanged();
     }
@@ -482,5 +828,60 @@ int ECGPlot::getSampleRate() const
 void ECGPlot::setSampleRate(int value)
 {
     sampleRate = value;
+
+    if (!signal.isEmpty())
+    {
+        updateGraphs();
+    }
+}
+
+void ECGPlot::setSegmentDuration(double seconds)
+{
+    segmentDuration = seconds;
+    unusableSegments.clear();
+
+    qualityShading->setSegments(&unusableSegments, segmentDuration);
+}
+
+void ECGPlot::setSegmentUsable(int segment, bool usable)
+{
+    if (segment >= unusableSegments.size())
+    {
+        unusableSegments.resize(segment + 1);
+    }
+
+    unusableSegments[segment] = !usable;
+}
+
+bool ECGPlot::isUsable(double time) const
+{
+    if (segmentDuration <= 0) return true;
+
+    int segment = (int) (time / segmentDuration);
+
+    return segment < 0 || segment >= unusableSegments.size() || !unusableSegments[segment];
 }
 
+void ECGPlot::setQualityShadingVisible(bool visible)
+{
+    qualityShading->setVisible(visible);
+    replot();
+}
+
+void ECGPlot::setSkipUnusableSegments(bool skip)
+{
+    skipUnusableSegments = skip;
+}
+
+int ECGPlot::peakAt(QPoint position) const
+{
+    int index = peaks.nearest(xAxis->pixelToCoord((double) position.x()));
+
+    // Same tolerance as the width of a peak marker
+    if (index != -1 && qAbs(xAxis->coordToPixel(peaks.at(index)) - position.x()) <= 5)
+    {
+        return index;
+    }
+
+    return -1;
+}
@@ -22,6 +22,12 @@
 
 #include <QRubberBand>
 #include "qcustomplot.h"
+#include "ecgsignal.h"
+#include "signalgraph.h"
+#include "peakstore.h"
+#include "peakmarkers.h"
+#include "qualityshading.h"
+#include "templatematcher.h"
 
 class ECGPlot : public QCustomPlot
 {
@@ -30,27 +36,42 @@ class ECGPlot : public QCustomPlot
 public:
     explicit ECGPlot(QWidget *parent);
     ~ECGPlot();
-    void plot(QVector<double> x, QVector<double> y);
+    void plot(const ECGSignal &signal);
+    void setFilteredSignal(const ECGSignal &filtered); // Shown and used for detection instead of the signal
+    void setBaseline(const ECGSignal &baseline); // Estimated baseline wander, see BaselineFilter
+    void invertSignal(); // Flips the polarity of the signal and everything derived from it
+    void setHeartRate(const QVector<double> &bpm, double rate); // Evenly sampled, shown on the right axis
+    void updateHeartRate(const QVector<double> &bpm, double rate, int from, int to); // Only samples [from, to) changed
     void clear();
     void peakdet(double local_threshold, double global_threshold, double minrrinterval);
-    QCPItemStraightLine* insertNewPeak(double position);
     void insertPeakAtClickPos(QPoint position);
     void insertPeakAtTimePoint(double position);
-    void insertPeaksFromVector(QVector<double> peaks_pos);
-    void deletePeak(QCPAbstractItem *peak);
-    void deletePeaks(QList<QCPAbstractItem*> peaksToDelete);
+    int insertPeaksFromVector(QVector<double> peaks_pos); // Returns number of rejected peaks
+    void replacePeaks(const QVector<double> &positions, const QVector<quint8> &flags); // Sorted, keeps the flags, e.g. after BeatCorrector
+    void deletePeak(int index);
+    void deleteSelectedPeaks();
     void clearPeaks();
+    int matchTemplate(const TemplateMatcher &matcher); // Refines peaks and flags ectopic beats, returns their number
+    BeatFeatures measureBeats() const; // Features of the current peaks
+    void updateBeatFeatures(); // Re-measures the peaks if they are colored by a feature
     void showIbiHighlightRect(double x, double width);
 
-    QVector<double> getEcg_x();
-    QVector<double> getEcg_y();
+    const ECGSignal &getSignal() const;
+    const ECGSignal &getFilteredSignal() const; // Empty if no filter is applied
+    const ECGSignal &activeSignal() const; // Filtered signal if there is one, used for detection and measurements
+    double getDuration() const;
 
-    QLinkedList<QCPItemStraightLine*> getPeaks();
+    const PeakStore &getPeaks() const;
     double getTimeBeforeFirstPeak();
 
     int getSampleRate() const;
     void setSampleRate(int value);
 
+    // Signal quality of fixed-length segments, see SignalQuality
+    void setSegmentDuration(double seconds); // Clears the segment quality
+    void setSegmentUsable(int segment, bool usable);
+    bool isUsable(double time) const; // Segments not assessed yet count as usable
+
 signals:
     // Emit at double click on empty position
     //void insertPeakAtPos(QPoint position);
@@ -61,10 +82,19 @@ signals:
     // Emit upon movement of the global threshold line
     void globalThresholdChanged(int);
     void peaksChanged();
+    // Emit when single peaks are inserted or deleted, with the replaced rows
+    void peaksEdited(const PeakEdit &edit);
+    // Emit when all peaks, or the signal they are measured on, changed
+    void peaksReset();
 
 public slots:
     void updateGlobalThresholdLine(int y);
     void setGlobalThresholdLineVisible(bool visible);
+    void setBaselineVisible(bool visible);
+    void setQualityShadingVisible(bool visible);
+    void setSkipUnusableSegments(bool skip); // Peak detection ignores peaks in unusable segments
+    void setPeakColorFeature(int feature); // See BeatFeatures::Feature, -1 for none
+    void setHeartRateVisible(bool visible);
 
 private slots:
     void mousePressEvent(QMouseEvent *event);
@@ -76,13 +106,31 @@ private slots:
     void highlightTimerUpdate();
 
 private:
-    QCPGraph *ecg;
-    QVector<double> ecg_x;
-    QVector<double> ecg_y;
+    SignalGraph *ecg;
+    ECGSignal signal;
+    ECGSignal filtered; // Empty if no filter is applied
+
+    SignalGraph *baselineGraph;
+    ECGSignal baseline;
+    bool baselineVisible;
+    void updateGraphs();
+
+    QCPGraph *heartRateGraph;
+    bool heartRateVisible;
 
     int sampleRate;
 
-    QLinkedList<QCPItemStraightLine*> peaks;
+    PeakStore peaks;
+    PeakMarkers *peakMarkers;
+    int peakAt(QPoint position) const; // Index of peak close to a pixel position, -1 if none
+
+    BeatFeatures features; // Only kept while peaks are colored by a feature
+    int colorFeature;
+
+    QualityShading *qualityShading;
+    QVector<bool> unusableSegments;
+    double segmentDuration;
+    bool skipUnusableSegments;
 
     QRubberBand *rubberBand;
     QPoint origin;
@@ -0,0 +1,563 @@
+/*
+ * Copyright (C) 2014-2015 Daniel Gromer
+ *
+ * This file is part of PeakMan.
+ *
+ * PeakMan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * PeakMan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PeakMan.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ecgsignal.h"
+#include <QDir>
+#include <qmath.h>
+#include <string.h>
+
+// Number of decoded blocks kept in memory for a swap file (32 MB)
+static const int CachedBlocks = 64;
+
+static const char *SwapFileName = "/peakman_XXXXXX.swap";
+
+// Decimal places of a quantization step that are tried for int16 storage
+static const int MaxDecimals = 6;
+static const double DecimalScale[MaxDecimals + 1] = {1, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6};
+
+const int ECGSignal::BlockSize;
+const int ECGSignal::SummarySize;
+
+qint64 ECGSignal::limit = 512 * 1048576;
+
+ECGSignal::ECGSignal()
+{
+    clear();
+}
+
+void ECGSignal::append(double value)
+{
+    // Samples are already missing, squeeze() clears the signal
+    if (swapFailed) return;
+
+    if (samples == 0)
+    {
+        minValue = value;
+        maxValue = value;
+    }
+    else
+    {
+        minValue = qMin(minValue, value);
+        maxValue = qMax(maxValue, value);
+    }
+
+    // Find the decimal places of the values (e.g. 3 for text files with mV
+    // values like 0.125), the samples are stored as int16 multiples of this
+    // step if the range allows it
+    while (decimals >= 0)
+    {
+        double scaled = value * DecimalScale[decimals];
+
+        // Floats only keep a quarter step of precision up to 2^22 steps
+        if (qAbs(scaled) >= (decimals == 0 ? 16777216 : 4194304))
+        {
+            decimals = -1;
+        }
+        else if (qAbs(scaled - qRound64(scaled)) <= 1e-6)
+        {
+            break;
+        }
+        else
+        {
+            decimals = decimals < MaxDecimals ? decimals + 1 : -1;
+        }
+    }
+
+    // Update min/max summary
+    if (samples % SummarySize == 0)
+    {
+        summaryMin << (float) value;
+        summaryMax << (float) value;
+    }
+    else
+    {
+        summaryMin.last() = qMin(summaryMin.last(), (float) value);
+        summaryMax.last() = qMax(summaryMax.last(), (float) value);
+    }
+
+    samples++;
+
+    if (!swapFile)
+    {
+        // Samples are staged as floats while loading, see squeeze()
+        float32Samples << (float) value;
+
+        if (spillable && (qint64) float32Samples.size() * (qint64) sizeof(float) > limit)
+        {
+            spill();
+        }
+
+        return;
+    }
+
+    // Signal is written to the swap file, int16Samples/float32Samples are
+    // used as write buffer now
+    if (enc == Int16)
+    {
+        double raw = (value - sampleOffset) / sampleGain;
+
+        if (qAbs(raw - qRound(raw)) <= 1e-3 && raw >= -32768 && raw <= 32767)
+        {
+            int16Samples << (qint16) qRound(raw);
+        }
+        else
+        {
+            // Value does not fit into int16, fall back to float32
+            if (!convertSwapFileToFloat32()) return;
+
+            float32Samples << (float) value;
+        }
+    }
+    else
+    {
+        float32Samples << (float) value;
+    }
+
+    if (int16Samples.size() + float32Samples.size() >= BlockSize)
+    {
+        flushWriteBuffer();
+    }
+}
+
+void ECGSignal::squeeze()
+{
+    if (swapFile)
+    {
+        if (mapped) return;
+
+        flushWriteBuffer();
+
+        if (swapFailed || !swapFile->file.flush())
+        {
+            clear();
+            return;
+        }
+
+        // If mapping fails, blocks are read from the file instead
+        mapped = swapFile->file.map(0, swapFile->file.size());
+
+        return;
+    }
+
+    if (enc == Int16 || float32Samples.isEmpty()) return;
+
+    if (quantize())
+    {
+        int16Samples.resize(float32Samples.size());
+
+        const float *in = float32Samples.constData();
+        qint16 *out = int16Samples.data();
+        double scale = 1 / sampleGain;
+
+        for (int i = 0; i < int16Samples.size(); i++)
+        {
+            out[i] = (qint16) qRound((in[i] - sampleOffset) * scale);
+        }
+
+        float32Samples.clear();
+        enc = Int16;
+    }
+    else
+    {
+        float32Samples.squeeze();
+    }
+}
+
+void ECGSignal::clear()
+{
+    int16Samples.clear();
+    float32Samples.clear();
+
+    swapFile.clear();
+    cache.clear();
+    mapped = 0;
+    swapSize = 0;
+    spillable = true;
+    swapFailed = false;
+
+    summaryMin.clear();
+    summaryMax.clear();
+
+    enc = Float32;
+    sampleGain = 1;
+    sampleOffset = 0;
+    samples = 0;
+
+    minValue = 0;
+    maxValue = 0;
+    decimals = 0;
+}
+
+bool ECGSignal::quantize()
+{
+    // Data with a fixed number of decimal places (e.g. raw adc counts or
+    // values in mV from text files) and a range of 16 bit is stored as int16
+    // multiples of the quantization step, shifted by an offset if it does
+    // not fit into the signed range
+    if (decimals < 0) return false;
+
+    double scale = DecimalScale[decimals];
+    double low = qRound64(minValue * scale);
+    double high = qRound64(maxValue * scale);
+
+    if (high - low > 65535) return false;
+
+    sampleGain = 1 / scale;
+    sampleOffset = 0;
+
+    if (low < -32768 || high > 32767)
+    {
+        // Offset is a multiple of the step, so the stored values stay exact
+        sampleOffset = (low + 32768) / scale;
+    }
+
+    return true;
+}
+
+void ECGSignal::invert()
+{
+    // Only the conversion to voltage changes, the stored samples are shared
+    // with other copies of the signal and stay as they are
+    sampleGain = -sampleGain;
+    sampleOffset = -sampleOffset;
+
+    double minimum = minValue;
+    minValue = -maxValue;
+    maxValue = -minimum;
+
+    for (int i = 0; i < summaryMin.size(); i++)
+    {
+        float minimum = summaryMin[i];
+        summaryMin[i] = -summaryMax[i];
+        summaryMax[i] = -minimum;
+    }
+
+    // Decoded blocks have the old gain baked in, and the cache is shared with
+    // copies that keep the old polarity
+    if (swapFile)
+    {
+        cache = QSharedPointer<BlockCache>(new BlockCache);
+        cache->blocks.setMaxCost(CachedBlocks);
+    }
+}
+
+bool ECGSignal::isEmpty() const
+{
+    return samples == 0;
+}
+
+int ECGSignal::size() const
+{
+    return samples;
+}
+
+void ECGSignal::read(int from, int count, double *out) const
+{
+    if (swapFile)
+    {
+        while (count > 0)
+        {
+            int block = from / BlockSize;
+            int start = from % BlockSize;
+            int n = qMin(count, BlockSize - start);
+
+            QVector<double> decoded;
+
+            {
+                QMutexLocker locker(&cache->mutex);
+
+                if (QVector<double> *cached = cache->blocks.object(block))
+                {
+                    // Shallow copy, stays valid if the block is evicted
+                    decoded = *cached;
+                }
+                else
+                {
+                    decoded.resize(qMin(BlockSize, swapSize - block * BlockSize));
+                    decodeBlock(block, decoded.data());
+                    cache->blocks.insert(block, new QVector<double>(decoded));
+                }
+            }
+
+            memcpy(out, decoded.constData() + start, n * sizeof(double));
+
+            from += n;
+            out += n;
+            count -= n;
+        }
+
+        return;
+    }
+
+    // Plain loops without branches, so the compiler can vectorize them
+    if (enc == Int16)
+    {
+        const qint16 *in = int16Samples.constData() + from;
+
+        for (int i = 0; i < count; i++)
+        {
+            out[i] = in[i] * sampleGain + sampleOffset;
+        }
+    }
+    else
+    {
+        const float *in = float32Samples.constData() + from;
+
+        for (int i = 0; i < count; i++)
+        {
+            out[i] = in[i] * sampleGain + sampleOffset;
+        }
+    }
+}
+
+int ECGSignal::summaryCount() const
+{
+    return summaryMin.size();
+}
+
+double ECGSignal::summaryMinimum(int bucket) const
+{
+    return summaryMin.at(bucket);
+}
+
+double ECGSignal::summaryMaximum(int bucket) const
+{
+    return summaryMax.at(bucket);
+}
+
+ECGSignal::Encoding ECGSignal::encoding() const
+{
+    return enc;
+}
+
+double ECGSignal::gain() const
+{
+    return sampleGain;
+}
+
+double ECGSignal::offset() const
+{
+    return sampleOffset;
+}
+
+double ECGSignal::minimum() const
+{
+    return minValue;
+}
+
+double ECGSignal::maximum() const
+{
+    return maxValue;
+}
+
+qint64 ECGSignal::bytes() const
+{
+    qint64 summaryBytes = (qint64) 2 * summaryMin.size() * sizeof(float);
+
+    if (swapFile)
+    {
+        return summaryBytes + (qint64) cache->blocks.totalCost() * BlockSize * sizeof(double);
+    }
+
+    return summaryBytes + (qint64) int16Samples.size() * sizeof(qint16) + (qint64) float32Samples.size() * sizeof(float);
+}
+
+bool ECGSignal::isMapped() const
+{
+    return !swapFile.isNull();
+}
+
+qint64 ECGSignal::memoryLimit()
+{
+    return limit;
+}
+
+void ECGSignal::setMemoryLimit(qint64 bytes)
+{
+    limit = bytes;
+}
+
+void ECGSignal::spill()
+{
+    swapFile = QSharedPointer<SwapFile>(new SwapFile(QDir::tempPath() + SwapFileName));
+
+    if (!swapFile->file.open())
+    {
+        // Keep the signal in memory
+        swapFile.clear();
+        spillable = false;
+        return;
+    }
+
+    cache = QSharedPointer<BlockCache>(new BlockCache);
+    cache->blocks.setMaxCost(CachedBlocks);
+
+    // Pick the encoding from the samples seen so far, see squeeze()
+    if (quantize())
+    {
+        enc = Int16;
+    }
+
+    QVector<float> staged = float32Samples;
+    float32Samples.clear();
+
+    for (int from = 0; from < staged.size(); from += BlockSize)
+    {
+        int n = qMin(BlockSize, staged.size() - from);
+
+        for (int i = 0; i < n; i++)
+        {
+            if (enc == Int16)
+            {
+                int16Samples << (qint16) qRound((staged[from + i] - sampleOffset) / sampleGain);
+            }
+            else
+            {
+                float32Samples << staged[from + i];
+            }
+        }
+
+        flushWriteBuffer();
+    }
+}
+
+void ECGSignal::flushWriteBuffer()
+{
+    if (!int16Samples.isEmpty())
+    {
+        qint64 bytes = int16Samples.size() * sizeof(qint16);
+
+        if (swapFile->file.write((const char*) int16Samples.constData(), bytes) != bytes) swapFailed = true;
+
+        swapSize += int16Samples.size();
+        int16Samples.clear();
+    }
+
+    if (!float32Samples.isEmpty())
+    {
+        qint64 bytes = float32Samples.size() * sizeof(float);
+
+        if (swapFile->file.write((const char*) float32Samples.constData(), bytes) != bytes) swapFailed = true;
+
+        swapSize += float32Samples.size();
+        float32Samples.clear();
+    }
+}
+
+bool ECGSignal::convertSwapFileToFloat32()
+{
+    flushWriteBuffer();
+
+    QSharedPointer<SwapFile> converted(new SwapFile(QDir::tempPath() + SwapFileName));
+
+    // The old file and encoding are kept if the conversion fails, squeeze()
+    // then drops the signal
+    if (swapFailed || !swapFile->file.flush() || !converted->file.open())
+    {
+        swapFailed = true;
+        return false;
+    }
+
+    swapFile->file.seek(0);
+
+    // Re-encode the file in blocks
+    QVector<qint16> in(BlockSize);
+    QVector<float> out(BlockSize);
+
+    for (int from = 0; from < swapSize; from += BlockSize)
+    {
+        int n = qMin(BlockSize, swapSize - from);
+        qint64 inBytes = n * sizeof(qint16);
+        qint64 outBytes = n * sizeof(float);
+
+        if (swapFile->file.read((char*) in.data(), inBytes) != inBytes)
+        {
+            swapFailed = true;
+            break;
+        }
+
+        for (int i = 0; i < n; i++)
+        {
+            out[i] = in[i] * sampleGain + sampleOffset;
+        }
+
+        if (converted->file.write((const char*) out.constData(), outBytes) != outBytes)
+        {
+            swapFailed = true;
+            break;
+        }
+    }
+
+    if (swapFailed)
+    {
+        swapFile->file.seek(swapFile->file.size());
+        return false;
+    }
+
+    swapFile = converted;
+    enc = Float32;
+    sampleGain = 1;
+    sampleOffset = 0;
+    decimals = -1;
+
+    return true;
+}
+
+void ECGSignal::decodeBlock(int block, double *out) const
+{
+    qint64 from = (qint64) block * BlockSize;
+    int n = qMin(BlockSize, swapSize - block * BlockSize);
+    int sampleBytes = enc == Int16 ? sizeof(qint16) : sizeof(float);
+
+    QByteArray buffer;
+    const uchar *raw = mapped ? mapped + from * sampleBytes : 0;
+
+    if (!raw)
+    {
+        // Mapping failed, read the block from the swap file. The file
+        // position is shared with copies that have a cache of their own.
+        QMutexLocker locker(&swapFile->mutex);
+
+        swapFile->file.seek(from * sampleBytes);
+        buffer = swapFile->file.read(n * sampleBytes);
+
+        // Samples missing from a short read decode as zero
+        if (buffer.size() < n * sampleBytes) buffer.append(QByteArray(n * sampleBytes - buffer.size(), 0));
+        raw = (const uchar*) buffer.constData();
+    }
+
+    if (enc == Int16)
+    {
+        const qint16 *in = (const qint16*) raw;
+
+        for (int i = 0; i < n; i++)
+        {
+            out[i] = in[i] * sampleGain + sampleOffset;
+        }
+    }
+    else
+    {
+        const float *in = (const float*) raw;
+
+        for (int i = 0; i < n; i++)
+        {
+            out[i] = in[i] * sampleGain + sampleOffset;
+        }
+    }
+}
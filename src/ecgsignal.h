@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2014-2015 Daniel Gromer
+ *
+ * This file is part of PeakMan.
+ *
+ * PeakMan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * PeakMan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PeakMan.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ECGSIGNAL_H
+#define ECGSIGNAL_H
+
+#include <QVector>
+#include <QCache>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QTemporaryFile>
+
+// Compact storage for an ecg signal. Samples are kept as 16 bit integers or
+// 32 bit floats and are converted to voltage with value = raw * gain + offset.
+//
+// Signals larger than the memory limit are moved to a temporary swap file
+// while loading. The swap file is memory-mapped and read in blocks, with a
+// small LRU cache of decoded blocks, so resident memory stays bounded.
+class ECGSignal
+{
+public:
+    enum Encoding { Int16, Float32 };
+
+    static const int BlockSize = 65536; // Samples per decoded block of a swap file
+    static const int SummarySize = 1024; // Samples per min/max summary bucket
+
+    ECGSignal();
+
+    void append(double value);
+    void squeeze(); // Finish loading and pick the most compact encoding, empty if the swap file failed
+    void clear();
+    void invert(); // Flip the polarity after loading, without touching the samples
+
+    bool isEmpty() const;
+    int size() const;
+    double at(int i) const;
+    void read(int from, int count, double *out) const; // Decode a block of samples
+
+    // Min/max of each SummarySize samples, used for drawing zoomed out views
+    int summaryCount() const;
+    double summaryMinimum(int bucket) const;
+    double summaryMaximum(int bucket) const;
+
+    Encoding encoding() const;
+    double gain() const;
+    double offset() const;
+    double minimum() const;
+    double maximum() const;
+    qint64 bytes() const; // Resident memory used by the samples
+    bool isMapped() const;
+
+    static qint64 memoryLimit();
+    static void setMemoryLimit(qint64 bytes);
+
+private:
+    struct BlockCache
+    {
+        QMutex mutex;
+        QCache<int, QVector<double> > blocks;
+    };
+
+    // Shared by all copies of the signal, also those with another polarity
+    // and cache, so reads that seek the file hold a lock of their own
+    struct SwapFile
+    {
+        SwapFile(const QString &name) : file(name) {}
+
+        QMutex mutex;
+        QTemporaryFile file;
+    };
+
+    bool quantize(); // Pick gain and offset for int16 storage
+    void spill(); // Move staged samples to the swap file
+    void flushWriteBuffer();
+    bool convertSwapFileToFloat32();
+    void decodeBlock(int block, double *out) const;
+
+    Encoding enc;
+    double sampleGain;
+    double sampleOffset;
+    int samples;
+
+    QVector<qint16> int16Samples;
+    QVector<float> float32Samples;
+
+    // Swap file storage
+    QSharedPointer<SwapFile> swapFile;
+    QSharedPointer<BlockCache> cache;
+    const uchar *mapped;
+    int swapSize; // Samples written to the swap file
+    bool spillable;
+    bool swapFailed; // A write to the swap file failed, samples are missing
+
+    QVector<float> summaryMin;
+    QVector<float> summaryMax;
+
+    double minValue;
+    double maxValue;
+    int decimals; // Decimal places of all appended values, -1 if too many
+
+    static qint64 limit;
+};
+
+inline double ECGSignal::at(int i) const
+{
+    if (swapFile)
+    {
+        double value;
+        read(i, 1, &value);
+
+        return value;
+    }
+
+    if (enc == Int16)
+    {
+        return int16Samples.at(i) * sampleGain + sampleOffset;
+    }
+
+    return float32Samples.at(i) * sampleGain + sampleOffset;
+}
+
+#endif // ECGSIGNAL_H
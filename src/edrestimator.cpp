@@ -0,0 +1,220 @@
+/*
+ * Copyright (C) 2014-2015 Daniel Gromer
+ *
+ * This file is part of PeakMan.
+ *
+ * PeakMan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * PeakMan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PeakMan.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "edrestimator.h"
+#include "beatfeatures.h"
+#include "ecgfilter.h"
+#include <qmath.h>
+#include <algorithm>
+
+EDREstimator::EDREstimator()
+{
+    rate = 4;
+    lowCut = 0.1;
+    highCut = 0.5;
+    amplitudeScale = 0;
+    intervalScale = 0;
+}
+
+void EDREstimator::setRate(double rate)
+{
+    this->rate = rate;
+}
+
+void EDREstimator::setBand(double low, double high)
+{
+    lowCut = low;
+    highCut = high;
+}
+
+double EDREstimator::getRate() const
+{
+    return rate;
+}
+
+void EDREstimator::reset(const ECGSignal &signal, double sampleRate, const QVector<double> &peaks)
+{
+    clear();
+
+    if (signal.isEmpty() || sampleRate <= 0 || peaks.size() < 2) return;
+
+    int n = qFloor((signal.size() - 1) / sampleRate * rate) + 1;
+
+    amplitudeSeries.resize(n);
+    intervalSeries.resize(n);
+    edr.resize(n);
+
+    amplitudes.resize(peaks.size());
+    measure(signal, sampleRate, peaks, 0, peaks.size());
+    resample(peaks, 0, n);
+
+    // Scale both series to unit variance. The amplitude may rise or fall with
+    // inspiration depending on the lead, its sign follows the intervals,
+    // which always shorten.
+    ECGFilter bandPass;
+    bandPass.setHighPass(lowCut);
+    bandPass.setLowPass(highCut);
+
+    QVector<double> a = amplitudeSeries;
+    QVector<double> b = intervalSeries;
+    bandPass.apply(a.data(), n, rate);
+    bandPass.apply(b.data(), n, rate);
+
+    double aa = 0, bb = 0, ab = 0;
+
+    for (int k = 0; k < n; k++)
+    {
+        aa += a[k] * a[k];
+        bb += b[k] * b[k];
+        ab += a[k] * b[k];
+    }
+
+    amplitudeScale = aa > 0 ? (ab > 0 ? -1 : 1) / qSqrt(aa / n) : 0;
+    intervalScale = bb > 0 ? -1 / qSqrt(bb / n) : 0;
+
+    for (int k = 0; k < n; k++)
+    {
+        edr[k] = (a[k] * amplitudeScale + b[k] * intervalScale) / 2;
+    }
+}
+
+void EDREstimator::update(const ECGSignal &signal, double sampleRate, const QVector<double> &peaks, const PeakEdit &edit)
+{
+    // The cache missed an edit, start over
+    if (edr.isEmpty() || peaks.size() < 2 || peaks.size() != edit.peaks || amplitudes.size() != edit.sizeBefore())
+    {
+        reset(signal, sampleRate, peaks);
+        return;
+    }
+
+    // Replace the amplitudes of the removed beats by those of the inserted ones
+    edit.splice(amplitudes);
+    measure(signal, sampleRate, peaks, edit.start, edit.inserted);
+
+    // Interpolation changes between the neighbours of the edited beats, the
+    // interval of the beat after them changes as well. The first interval
+    // is held before the first beat.
+    int n = peaks.size();
+    int lo = edit.start;
+    int end = lo + edit.inserted;
+    double begin = lo > 1 ? peaks[lo - 1] : 0;
+    double finish = end + 1 < n ? peaks[end + 1] : edr.size() / rate;
+
+    int ka = qMax(0, qFloor(begin * rate));
+    int kb = qMin(edr.size(), qCeil(finish * rate) + 1);
+
+    resample(peaks, ka, kb);
+    filter(ka, kb);
+}
+
+void EDREstimator::clear()
+{
+    amplitudes.clear();
+    amplitudeSeries.clear();
+    intervalSeries.clear();
+    edr.clear();
+    amplitudeScale = 0;
+    intervalScale = 0;
+}
+
+bool EDREstimator::isEmpty() const
+{
+    return edr.isEmpty();
+}
+
+const QVector<double> &EDREstimator::values() const
+{
+    return edr;
+}
+
+void EDREstimator::measure(const ECGSignal &signal, double sampleRate, const QVector<double> &peaks, int first, int count)
+{
+    if (count <= 0) return;
+
+    BeatFeatures features;
+    features.compute(signal, sampleRate, count == peaks.size() ? peaks : peaks.mid(first, count));
+
+    QVector<double> measured = features.column(BeatFeatures::Amplitude);
+
+    for (int i = 0; i < count; i++)
+    {
+        amplitudes[first + i] = measured[i];
+    }
+}
+
+void EDREstimator::resample(const QVector<double> &beats, int from, int to)
+{
+    int n = beats.size();
+
+    // Last beat at or before the first grid sample, -1 if there is none
+    int j = std::upper_bound(beats.constBegin(), beats.constEnd(), from / rate) - beats.constBegin() - 1;
+
+    for (int k = from; k < to; k++)
+    {
+        double t = k / rate;
+
+        while (j + 1 < n && beats[j + 1] <= t) j++;
+
+        // Interval ending at a beat, the first beat has the one of the second
+        int a = qMax(0, qMin(j, n - 1));
+        int b = qMin(j + 1, n - 1);
+        double intervalA = beats[qMax(a, 1)] - beats[qMax(a, 1) - 1];
+        double intervalB = beats[qMax(b, 1)] - beats[qMax(b, 1) - 1];
+
+        if (j < 0 || j == n - 1)
+        {
+            // Held before the first and after the last beat
+            amplitudeSeries[k] = amplitudes[a];
+            intervalSeries[k] = intervalA;
+            continue;
+        }
+
+        double w = (t - beats[j]) / (beats[j + 1] - beats[j]);
+
+        amplitudeSeries[k] = amplitudes[a] + w * (amplitudes[b] - amplitudes[a]);
+        intervalSeries[k] = intervalA + w * (intervalB - intervalA);
+    }
+}
+
+void EDREstimator::filter(int from, int to)
+{
+    ECGFilter bandPass;
+    bandPass.setHighPass(lowCut);
+    bandPass.setLowPass(highCut);
+
+    // Filter some context on both sides and only keep the part where the
+    // transients of the cut edges have decayed. At the ends of the series
+    // the whole series is filtered the same way.
+    int n = edr.size();
+    int margin = bandPass.warmUp(rate);
+    int inFrom = qMax(0, from - 2 * margin);
+    int inTo = qMin(n, to + 2 * margin);
+    int outFrom = inFrom == 0 ? 0 : from - margin;
+    int outTo = inTo == n ? n : to + margin;
+
+    QVector<double> a = amplitudeSeries.mid(inFrom, inTo - inFrom);
+    QVector<double> b = intervalSeries.mid(inFrom, inTo - inFrom);
+    bandPass.apply(a.data(), a.size(), rate);
+    bandPass.apply(b.data(), b.size(), rate);
+
+    for (int k = outFrom; k < outTo; k++)
+    {
+        edr[k] = (a[k - inFrom] * amplitudeScale + b[k - inFrom] * intervalScale) / 2;
+    }
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2014-2015 Daniel Gromer
+ *
+ * This file is part of PeakMan.
+ *
+ * PeakMan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * PeakMan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PeakMan.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef EDRESTIMATOR_H
+#define EDRESTIMATOR_H
+
+#include <QVector>
+#include "ecgsignal.h"
+#include "peakedit.h"
+
+// ECG-derived respiration (EDR). Breathing modulates both the R amplitude
+// (the heart moves relative to the electrodes) and the interbeat intervals
+// (respiratory sinus arrhythmia). Both beat series are resampled to an even
+// grid, band-passed to the respiratory band and combined. The amplitude of
+// every beat is cached, so after an edit only the edited beats are measured
+// again and only the surrounding part of the series is recomputed.
+class EDREstimator
+{
+public:
+    EDREstimator();
+
+    void setRate(double rate); // Of the resampled series, in Hz
+    void setBand(double low, double high); // Respiratory band, in Hz
+
+    double getRate() const;
+
+    void reset(const ECGSignal &signal, double sampleRate, const QVector<double> &peaks);
+    void update(const ECGSignal &signal, double sampleRate, const QVector<double> &peaks, const PeakEdit &edit);
+    void clear();
+
+    bool isEmpty() const;
+    const QVector<double> &values() const; // Sample k at k / rate seconds, in standard deviations
+
+private:
+    void measure(const ECGSignal &signal, double sampleRate, const QVector<double> &peaks, int first, int count); // Amplitudes of beats [first, first + count)
+    void resample(const QVector<double> &beats, int from, int to); // Grid samples [from, to)
+    void filter(int from, int to); // Recomputes the output around grid samples [from, to)
+
+    double rate;
+    double lowCut;
+    double highCut;
+
+    QVector<double> amplitudes; // Cached R amplitude of every beat
+
+    QVector<double> amplitudeSeries; // Evenly resampled, before filtering
+    QVector<double> intervalSeries;
+    QVector<double> edr;
+
+    double amplitudeScale; // From the last reset, so that edits don't rescale the whole series
+    double intervalScale;
+};
+
+#endif // EDRESTIMATOR_H
@@ -0,0 +1,161 @@
+/*
+ * Copyright (C) 2014-2015 Daniel Gromer
+ *
+ * This file is part of PeakMan.
+ *
+ * PeakMan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * PeakMan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PeakMan.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ensembleaverager.h"
+#include <QThread>
+#include <QtConcurrentMap>
+#include <qmath.h>
+
+struct AverageGroup
+{
+    const ECGSignal *signal;
+    const QVector<int> *beats; // First sample of each window
+    const QVector<double> *shift; // Subtracted before squaring, keeps the sums small
+    int first; // Range of beats of this group
+    int last;
+    int length;
+
+    // Partial sums of this group
+    QVector<double> sum;
+    QVector<double> squares;
+    int count;
+};
+
+static void accumulateGroup(AverageGroup &group)
+{
+    int m = group.length;
+
+    group.sum = QVector<double>(m, 0);
+    group.squares = QVector<double>(m, 0);
+    group.count = 0;
+
+    QVector<double> window(m);
+
+    double *sum = group.sum.data();
+    double *squares = group.squares.data();
+    const double *shift = group.shift->constData();
+
+    for (int b = group.first; b < group.last; b++)
+    {
+        group.signal->read(group.beats->at(b), m, window.data());
+
+        // Element-wise, without branches, so the compiler can vectorize it
+        const double *x = window.constData();
+
+        for (int j = 0; j < m; j++)
+        {
+            double d = x[j] - shift[j];
+            sum[j] += d;
+            squares[j] += d * d;
+        }
+
+        group.count++;
+    }
+}
+
+EnsembleAverager::EnsembleAverager()
+{
+    windowBefore = 0.25;
+    windowAfter = 0.45;
+}
+
+void EnsembleAverager::setWindow(double before, double after)
+{
+    windowBefore = before;
+    windowAfter = after;
+}
+
+EnsembleAverager::Result EnsembleAverager::apply(const ECGSignal &signal, double sampleRate, const QVector<double> &peaks) const
+{
+    Result result;
+
+    int before = qRound(windowBefore * sampleRate);
+    int length = before + qRound(windowAfter * sampleRate) + 1;
+
+    if (sampleRate <= 0 || length < 2) return result;
+
+    // Beats whose window lies completely within the signal
+    QVector<int> beats;
+    beats.reserve(peaks.size());
+
+    for (int i = 0; i < peaks.size(); i++)
+    {
+        int from = qRound(peaks[i] * sampleRate) - before;
+
+        if (from >= 0 && from + length <= signal.size()) beats << from;
+    }
+
+    if (beats.isEmpty()) return result;
+
+    // The first beat is a good enough estimate of the mean to subtract, the
+    // sums of squares then stay small even for hundreds of thousands of beats
+    QVector<double> shift(length);
+    signal.read(beats.first(), length, shift.data());
+
+    int groupCount = qMin(beats.size(), qMax(1, QThread::idealThreadCount()));
+    QVector<AverageGroup> groups;
+
+    for (int g = 0; g < groupCount; g++)
+    {
+        AverageGroup group;
+        group.signal = &signal;
+        group.beats = &beats;
+        group.shift = &shift;
+        group.first = (int) ((qint64) beats.size() * g / groupCount);
+        group.last = (int) ((qint64) beats.size() * (g + 1) / groupCount);
+        group.length = length;
+
+        groups << group;
+    }
+
+    QtConcurrent::blockingMap(groups, accumulateGroup);
+
+    // Add up the partial sums
+    QVector<double> sum(length, 0);
+    QVector<double> squares(length, 0);
+    int n = 0;
+
+    for (int g = 0; g < groups.size(); g++)
+    {
+        for (int j = 0; j < length; j++)
+        {
+            sum[j] += groups[g].sum[j];
+            squares[j] += groups[g].squares[j];
+        }
+
+        n += groups[g].count;
+    }
+
+    result.beats = n;
+    result.time.resize(length);
+    result.mean.resize(length);
+    result.sd.resize(length);
+
+    for (int j = 0; j < length; j++)
+    {
+        double mean = sum[j] / n;
+        double variance = n > 1 ? (squares[j] - n * mean * mean) / (n - 1) : 0;
+
+        result.time[j] = (j - before) / sampleRate;
+        result.mean[j] = mean + shift[j];
+        result.sd[j] = qSqrt(qMax(variance, 0.0));
+    }
+
+    return result;
+}
@@ -0,0 +1,53 @@
+/*
+ * Copyright (C) 2014-2015 Daniel Gromer
+ *
+ * This file is part of PeakMan.
+ *
+ * PeakMan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * PeakMan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PeakMan.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ENSEMBLEAVERAGER_H
+#define ENSEMBLEAVERAGER_H
+
+#include <QVector>
+#include "ecgsignal.h"
+
+// Signal-averaged ecg: mean and standard deviation of fixed windows around
+// the R peaks. Beats are split into one group per thread, each group
+// accumulates its own partial sums, and the partial sums are added at the end.
+class EnsembleAverager
+{
+public:
+    struct Result
+    {
+        QVector<double> time; // Relative to the R peak, in seconds
+        QVector<double> mean;
+        QVector<double> sd;
+        int beats; // Beats that contributed
+
+        Result() : beats(0) {}
+    };
+
+    EnsembleAverager();
+
+    void setWindow(double before, double after); // In seconds
+
+    Result apply(const ECGSignal &signal, double sampleRate, const QVector<double> &peaks) const;
+
+private:
+    double windowBefore;
+    double windowAfter;
+};
+
+#endif // ENSEMBLEAVERAGER_H
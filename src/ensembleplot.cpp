@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2014-2015 Daniel Gromer
+ *
+ * This file is part of PeakMan.
+ *
+ * PeakMan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * PeakMan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PeakMan.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ensembleplot.h"
+
+EnsemblePlot::EnsemblePlot(QWidget *parent) : QCustomPlot(parent)
+{
+    // Standard deviation band, filled between the upper and lower graph
+    lower = addGraph();
+    lower->setPen(Qt::NoPen);
+
+    upper = addGraph();
+    upper->setPen(Qt::NoPen);
+    upper->setBrush(QBrush(QColor(66, 113, 174, 60)));
+    upper->setChannelFillGraph(lower);
+
+    mean = addGraph();
+    mean->setPen(QPen(QColor(77, 77, 76), 2));
+
+    // Set axis labels
+    xAxis->setLabel("Time relative to R peak (ms)");
+    yAxis->setLabel("Voltage (mV)");
+
+    setInteractions(QCP::iRangeDrag | QCP::iRangeZoom);
+
+    // Appereance of axis grid
+    xAxis->grid()->setPen(QPen(QColor(200, 200, 200), 1, Qt::DotLine));
+    yAxis->grid()->setPen(QPen(QColor(200, 200, 200), 1, Qt::DotLine));
+    xAxis->grid()->setSubGridPen(QPen(QColor(220, 220, 220), 1, Qt::DotLine));
+    yAxis->grid()->setSubGridPen(QPen(QColor(220, 220, 220), 1, Qt::DotLine));
+    xAxis->grid()->setSubGridVisible(true);
+    yAxis->grid()->setSubGridVisible(true);
+
+    replot();
+}
+
+EnsemblePlot::~EnsemblePlot()
+{
+
+}
+
+void EnsemblePlot::plot(const EnsembleAverager::Result &average)
+{
+    QVector<double> time(average.time.size());
+    QVector<double> upperValues(average.time.size());
+    QVector<double> lowerValues(average.time.size());
+
+    for (int i = 0; i < time.size(); i++)
+    {
+        time[i] = average.time[i] * 1000;
+        upperValues[i] = average.mean[i] + average.sd[i];
+        lowerValues[i] = average.mean[i] - average.sd[i];
+    }
+
+    mean->setData(time, average.mean);
+    upper->setData(time, upperValues);
+    lower->setData(time, lowerValues);
+
+    rescaleAxes();
+    replot();
+}
+
+void EnsemblePlot::clear()
+{
+    mean->clearData();
+    upper->clearData();
+    lower->clearData();
+
+    replot();
+}
@@ -0,0 +1,44 @@
+/*
+ * Copyright (C) 2014-2015 Daniel Gromer
+ *
+ * This file is part of PeakMan.
+ *
+ * PeakMan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * PeakMan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PeakMan.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ENSEMBLEPLOT_H
+#define ENSEMBLEPLOT_H
+
+#include "qcustomplot.h"
+#include "ensembleaverager.h"
+
+// Mean beat of an ensemble average, with a band of +/- one standard deviation
+class EnsemblePlot : public QCustomPlot
+{
+    Q_OBJECT
+
+public:
+    explicit EnsemblePlot(QWidget *parent);
+    ~EnsemblePlot();
+
+    void plot(const EnsembleAverager::Result &average);
+    void clear();
+
+private:
+    QCPGraph *mean;
+    QCPGraph *upper;
+    QCPGraph *lower;
+};
+
+#endif // ENSEMBLEPLOT_H
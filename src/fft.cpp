@@ -0,0 +1,135 @@
+/*
+ * Copyright (C) 2014-2015 Daniel Gromer
+ *
+ * This file is part of PeakMan.
+ *
+ * PeakMan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * PeakMan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PeakMan.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "fft.h"
+#include <qmath.h>
+
+void FFT::forward(QVector<double> &re, QVector<double> &im)
+{
+    transform(re, im, false);
+}
+
+void FFT::inverse(QVector<double> &re, QVector<double> &im)
+{
+    transform(re, im, true);
+
+    int n = re.size();
+
+    for (int i = 0; i < n; i++)
+    {
+        re[i] /= n;
+        im[i] /= n;
+    }
+}
+
+QVector<double> FFT::powerSpectrum(const double *samples, int n, int size)
+{
+    QVector<double> re(size, 0);
+    QVector<double> im(size, 0);
+
+    double mean = 0;
+
+    for (int i = 0; i < n; i++) mean += samples[i];
+
+    mean /= qMax(n, 1);
+
+    for (int i = 0; i < n && i < size; i++)
+    {
+        double window = n > 1 ? 0.5 - 0.5 * qCos(2 * M_PI * i / (n - 1)) : 1;
+        re[i] = (samples[i] - mean) * window;
+    }
+
+    forward(re, im);
+
+    QVector<double> power(size / 2 + 1);
+
+    for (int k = 0; k <= size / 2; k++)
+    {
+        power[k] = re[k] * re[k] + im[k] * im[k];
+    }
+
+    return power;
+}
+
+int FFT::nextPowerOfTwo(int n)
+{
+    int size = 1;
+
+    while (size < n) size *= 2;
+
+    return size;
+}
+
+void FFT::transform(QVector<double> &re, QVector<double> &im, bool inverse)
+{
+    int n = re.size();
+
+    if (n < 2) return;
+
+    double *r = re.data();
+    double *m = im.data();
+
+    // Bit reversal permutation
+    for (int i = 1, j = 0; i < n; i++)
+    {
+        int bit = n >> 1;
+
+        for (; j & bit; bit >>= 1) j ^= bit;
+
+        j ^= bit;
+
+        if (i < j)
+        {
+            qSwap(r[i], r[j]);
+            qSwap(m[i], m[j]);
+        }
+    }
+
+    // Butterflies, twiddle factors by recurrence within each stage
+    for (int length = 2; length <= n; length *= 2)
+    {
+        double angle = (inverse ? 2 : -2) * M_PI / length;
+        double wr = qCos(angle);
+        double wi = qSin(angle);
+
+        for (int start = 0; start < n; start += length)
+        {
+            double cr = 1;
+            double ci = 0;
+
+            for (int k = 0; k < length / 2; k++)
+            {
+                int a = start + k;
+                int b = a + length / 2;
+
+                double tr = r[b] * cr - m[b] * ci;
+                double ti = r[b] * ci + m[b] * cr;
+
+                r[b] = r[a] - tr;
+                m[b] = m[a] - ti;
+                r[a] += tr;
+                m[a] += ti;
+
+                double next = cr * wr - ci * wi;
+                ci = cr * wi + ci * wr;
+                cr = next;
+            }
+        }
+    }
+}
@@ -0,0 +1,43 @@
+/*
+ * Copyright (C) 2014-2015 Daniel Gromer
+ *
+ * This file is part of PeakMan.
+ *
+ * PeakMan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * PeakMan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PeakMan.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FFT_H
+#define FFT_H
+
+#include <QVector>
+
+// In-place radix-2 fast Fourier transform on separate real and imaginary
+// parts. Sizes must be powers of two, see nextPowerOfTwo().
+class FFT
+{
+public:
+    static void forward(QVector<double> &re, QVector<double> &im);
+    static void inverse(QVector<double> &re, QVector<double> &im); // Scaled by 1 / n
+
+    // One-sided power spectrum of n samples with a Hann window, zero-padded to
+    // size (a power of two). Bin k is at frequency k * sampleRate / size.
+    static QVector<double> powerSpectrum(const double *samples, int n, int size);
+
+    static int nextPowerOfTwo(int n);
+
+private:
+    static void transform(QVector<double> &re, QVector<double> &im, bool inverse);
+};
+
+#endif // FFT_H
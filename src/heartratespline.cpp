@@ -0,0 +1,238 @@
+/*
+ * Copyright (C) 2014-2015 Daniel Gromer
+ *
+ * This file is part of PeakMan.
+ *
+ * PeakMan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * PeakMan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PeakMan.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "heartratespline.h"
+#include <qmath.h>
+#include <algorithm>
+
+// Knots solved again on each side of an edit, the error at the window edges
+// shrinks by 0.27^Window before it reaches the edited knots
+static const int Window = 24;
+
+HeartRateSpline::HeartRateSpline()
+{
+    rate = 4;
+    duration = 0;
+    firstKnot = 0;
+    lastKnot = 0;
+    firstChanged = 0;
+    endChanged = 0;
+}
+
+void HeartRateSpline::setRate(double rate)
+{
+    this->rate = rate;
+}
+
+double HeartRateSpline::getRate() const
+{
+    return rate;
+}
+
+void HeartRateSpline::reset(const QVector<double> &peaks, double duration)
+{
+    clear();
+
+    this->duration = duration;
+
+    if (peaks.size() < 2 || duration <= 0) return;
+
+    int n = peaks.size();
+
+    bpm = QVector<double>(n, 0);
+    curvature = QVector<double>(n, 0);
+
+    for (int i = 1; i < n; i++)
+    {
+        bpm[i] = 60 / (peaks[i] - peaks[i - 1]);
+    }
+
+    firstKnot = peaks[1];
+    lastKnot = peaks.last();
+
+    series.resize(qFloor(duration * rate) + 1);
+
+    solve(peaks, 1, n - 1);
+    evaluate(peaks, 0, series.size());
+}
+
+void HeartRateSpline::update(const QVector<double> &peaks, const PeakEdit &edit)
+{
+    // The rows missed an edit, start over
+    if (series.isEmpty() || peaks.size() < 2 || peaks.size() != edit.peaks || bpm.size() != edit.sizeBefore())
+    {
+        reset(peaks, duration);
+        return;
+    }
+
+    // Replace the rows of the removed beats by those of the inserted ones
+    edit.splice(bpm);
+    edit.splice(curvature);
+
+    firstKnot = peaks[1];
+    lastKnot = peaks.last();
+
+    // Knots of the inserted beats and of the beat after them changed
+    int n = peaks.size();
+    int lo = edit.start;
+    int end = qMin(lo + edit.inserted, n - 1);
+
+    for (int i = qMax(lo, 1); i <= end; i++)
+    {
+        bpm[i] = 60 / (peaks[i] - peaks[i - 1]);
+    }
+
+    int a = qMax(1, lo - Window);
+    int b = qMin(n - 1, end + Window);
+
+    // Natural spline at the ends of the series
+    if (a == 1) curvature[1] = 0;
+    if (b == n - 1) curvature[n - 1] = 0;
+
+    solve(peaks, a, b);
+
+    // Samples between the window edges, up to the ends of the series where
+    // the rate is held
+    int ka = a == 1 ? 0 : qFloor(peaks[a] * rate);
+    int kb = b == n - 1 ? series.size() : qMin(series.size(), qCeil(peaks[b] * rate) + 1);
+
+    evaluate(peaks, ka, kb);
+}
+
+void HeartRateSpline::clear()
+{
+    bpm.clear();
+    curvature.clear();
+    series.clear();
+    firstChanged = 0;
+    endChanged = 0;
+}
+
+bool HeartRateSpline::isEmpty() const
+{
+    return series.isEmpty();
+}
+
+const QVector<double> &HeartRateSpline::values() const
+{
+    return series;
+}
+
+int HeartRateSpline::firstSample() const
+{
+    return series.isEmpty() ? 0 : qMin(series.size(), qCeil(firstKnot * rate));
+}
+
+int HeartRateSpline::lastSample() const
+{
+    return series.isEmpty() ? -1 : qMin(series.size() - 1, qFloor(lastKnot * rate));
+}
+
+int HeartRateSpline::changedFrom() const
+{
+    return firstChanged;
+}
+
+int HeartRateSpline::changedTo() const
+{
+    return endChanged;
+}
+
+void HeartRateSpline::solve(const QVector<double> &beats, int from, int to)
+{
+    int m = to - from - 1;
+
+    if (m <= 0) return;
+
+    // Thomas algorithm, c and d are the modified upper diagonal and right side
+    QVector<double> c(m);
+    QVector<double> d(m);
+
+    for (int r = 0; r < m; r++)
+    {
+        int j = from + 1 + r;
+        double h0 = beats[j] - beats[j - 1];
+        double h1 = beats[j + 1] - beats[j];
+
+        double sub = h0;
+        double diag = 2 * (h0 + h1);
+        double sup = h1;
+        double rhs = 6 * ((bpm[j + 1] - bpm[j]) / h1 - (bpm[j] - bpm[j - 1]) / h0);
+
+        // Known second derivatives at the window edges
+        if (r == 0) rhs -= sub * curvature[from];
+        if (r == m - 1) rhs -= sup * curvature[to];
+
+        if (r > 0)
+        {
+            double w = diag - sub * c[r - 1];
+            c[r] = sup / w;
+            d[r] = (rhs - sub * d[r - 1]) / w;
+        }
+        else
+        {
+            c[r] = sup / diag;
+            d[r] = rhs / diag;
+        }
+    }
+
+    curvature[to - 1] = d[m - 1];
+
+    for (int r = m - 2; r >= 0; r--)
+    {
+        curvature[from + 1 + r] = d[r] - c[r] * curvature[from + 2 + r];
+    }
+}
+
+void HeartRateSpline::evaluate(const QVector<double> &beats, int from, int to)
+{
+    firstChanged = from;
+    endChanged = to;
+
+    int n = beats.size();
+
+    // Last beat at or before the first sample
+    int j = std::upper_bound(beats.constBegin(), beats.constEnd(), from / rate) - beats.constBegin() - 1;
+
+    for (int k = from; k < to; k++)
+    {
+        double t = k / rate;
+
+        while (j + 1 < n && beats[j + 1] <= t) j++;
+
+        if (j < 1)
+        {
+            series[k] = bpm[1];
+        }
+        else if (j >= n - 1)
+        {
+            series[k] = bpm[n - 1];
+        }
+        else
+        {
+            double h = beats[j + 1] - beats[j];
+            double u = beats[j + 1] - t;
+            double v = t - beats[j];
+
+            series[k] = (curvature[j] * u * u * u + curvature[j + 1] * v * v * v) / (6 * h)
+                    + (bpm[j] / h - curvature[j] * h / 6) * u
+                    + (bpm[j + 1] / h - curvature[j + 1] * h / 6) * v;
+        }
+    }
+}
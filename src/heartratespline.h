@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2014-2015 Daniel Gromer
+ *
+ * This file is part of PeakMan.
+ *
+ * PeakMan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * PeakMan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PeakMan.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HEARTRATESPLINE_H
+#define HEARTRATESPLINE_H
+
+#include <QVector>
+#include "peakedit.h"
+
+// Instantaneous heart rate resampled to an even grid. Each beat is a knot at
+// the end of its interbeat interval, the knots are joined by a natural cubic
+// spline whose second derivatives come from a tridiagonal solve in linear
+// time. The influence of a knot on the spline decays by a factor of about
+// 0.27 per knot, so after an edit only a window of knots around it is solved
+// again, with the second derivatives at the window edges kept.
+class HeartRateSpline
+{
+public:
+    HeartRateSpline();
+
+    void setRate(double rate); // Of the resampled series, in Hz
+    double getRate() const;
+
+    void reset(const QVector<double> &peaks, double duration);
+    void update(const QVector<double> &peaks, const PeakEdit &edit);
+    void clear();
+
+    bool isEmpty() const;
+    const QVector<double> &values() const; // Sample k at k / rate seconds, in beats per minute
+    int firstSample() const; // Range of samples between the first and the last knot,
+    int lastSample() const; // the rate is held constant outside of it
+    int changedFrom() const; // Samples [changedFrom, changedTo) evaluated again
+    int changedTo() const; // by the last reset or update
+
+private:
+    void solve(const QVector<double> &beats, int from, int to); // Second derivatives of knots (from, to), those at from and to are kept
+    void evaluate(const QVector<double> &beats, int from, int to); // Grid samples [from, to)
+
+    double rate;
+    double duration;
+    double firstKnot; // In seconds
+    double lastKnot;
+
+    // One row per beat, the first beat has no interval and is not a knot
+    QVector<double> bpm;
+    QVector<double> curvature; // Second derivatives of the spline
+
+    QVector<double> series;
+    int firstChanged;
+    int endChanged;
+};
+
+#endif // HEARTRATESPLINE_H
@@ -21,6 +21,20 @@
 
 HistPlot::HistPlot(QWidget *parent) : QCustomPlot(parent)
 {
+    histogram = 0;
+    binWidth = 10;
+    densityVisible = false;
+
+    // Plottables are kept, only their data changes
+    bars = new QCPBars(xAxis, yAxis);
+    addPlottable(bars);
+    bars->setWidth(binWidth);
+    bars->setPen(QPen(Qt::black));
+    bars->setBrush(QColor(77, 77, 76));
+
+    density = addGraph();
+    density->setPen(QPen(QColor(200, 40, 41), 2));
+
     // Appereance of axis grid
     xAxis->grid()->setPen(QPen(QColor(200, 200, 200), 1, Qt::DotLine));
     yAxis->grid()->setPen(QPen(QColor(200, 200, 200), 1, Qt::DotLine));
@@ -62,49 +76,65 @@ HistPlot::~HistPlot()
 //    replot();
 //}
 
-void HistPlot::plot(QVector<double> ibis, double maxIbi)
+void HistPlot::setHistogram(const IntervalHistogram *histogram)
+{
+    this->histogram = histogram;
+}
+
+void HistPlot::clear()
+{
+    bars->clearData();
+    density->clearData();
+    replot();
+}
+
+void HistPlot::setup()
+{
+    if (histogram) refresh();
+}
+
+void HistPlot::setBinWidth(int width)
 {
-    QVector<double> hist_y = QVector<double>(qFloor(maxIbi / 10) + 1);
-    QVector<double> hist_x = QVector<double>(hist_y.size());
+    binWidth = qMax(1, width);
+
+    if (histogram && !histogram->isEmpty()) refresh();
+}
+
+void HistPlot::setDensityVisible(bool visible)
+{
+    densityVisible = visible;
+
+    if (histogram && !histogram->isEmpty()) refresh();
+}
+
+void HistPlot::refresh()
+{
+    QVector<double> hist_x, hist_y;
+    histogram->binned(binWidth, hist_x, hist_y);
 
     double maxHistValue = 0;
 
-    for (int i = 0; i < ibis.size(); i++)
+    for (int i = 0; i < hist_y.size(); i++)
     {
-        hist_y[qFloor(ibis[i] / 10)]++;
+        maxHistValue = qMax(maxHistValue, hist_y[i]);
     }
 
-    for (int i = 0; i < hist_x.size(); i++)
+    bars->setWidth(binWidth);
+    bars->setData(hist_x, hist_y);
+
+    if (densityVisible)
     {
-        hist_x[i] = i * 10 + 5;
-        maxHistValue = qMax(maxHistValue, hist_y[i]);
+        QVector<double> density_x, density_y;
+        histogram->density(binWidth, density_x, density_y);
+        density->setData(density_x, density_y);
     }
-
-    if (plottableCount() > 0)
+    else
     {
-        removePlottable(0);
+        density->clearData();
     }
 
-    QCPBars *bars = new QCPBars(xAxis, yAxis);
-    addPlottable(bars);
-    bars->setWidth(10);
-    bars->setData(hist_x, hist_y);
-    bars->setPen(QPen(Qt::black));
-    bars->setBrush(QColor(77, 77, 76));
-
-    xAxis->setRange(0, maxIbi + 20);
-    yAxis->setRange(0, maxHistValue + 5);
-
-    replot();
-}
+    xAxis->setRange(0, histogram->maximum() + 20);
+    yAxis->setRange(0, maxHistValue * 1.05 + 5);
 
-void HistPlot::clear()
-{
-    removePlottable(0);
     replot();
 }
-
-void HistPlot::setup(QVector<double> ibis, double maxIbi)
-{
-    plot(ibis, maxIbi);
-}
@@ -21,6 +21,7 @@
 #define HISTPLOT_H
 
 #include "qcustomplot.h"
+#include "intervalhistogram.h"
 
 class HistPlot : public QCustomPlot
 {
@@ -30,11 +31,22 @@ public:
     explicit HistPlot(QWidget *parent);
     ~HistPlot();
 
-    void plot(QVector<double> ibis, double maxIbi);
+    void setHistogram(const IntervalHistogram *histogram); // Kept up to date by the owner
     void clear();
 
 public slots:
-    void setup(QVector<double> ibis, double maxIbi);
+    void setup(); // Shows the current state of the histogram
+    void setBinWidth(int width); // In ms, re-binned from the base histogram
+    void setDensityVisible(bool visible);
+
+private:
+    void refresh();
+
+    const IntervalHistogram *histogram;
+    QCPBars *bars;
+    QCPGraph *density; // Kernel density estimate over the bars
+    int binWidth;
+    bool densityVisible;
 };
 
 #endif // HISTPLOT_H
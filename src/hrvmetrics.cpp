@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2014-2015 Daniel Gromer
+ *
+ * This file is part of PeakMan.
+ *
+ * PeakMan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * PeakMan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PeakMan.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "hrvmetrics.h"
+#include <qmath.h>
+
+HRVMetrics::HRVMetrics()
+{
+    clear();
+}
+
+void HRVMetrics::reset(const QVector<double> &peaks)
+{
+    clear();
+
+    if (peaks.size() > 1) shift = peaks[1] - peaks[0];
+
+    accumulate(peaks, 0, peaks.size() - 1, 1);
+}
+
+void HRVMetrics::update(const QVector<double> &peaks, const PeakEdit &edit)
+{
+    // The sums missed an edit, start over
+    if (count != qMax(edit.sizeBefore() - 1, 0) || peaks.size() != edit.peaks)
+    {
+        reset(peaks);
+        return;
+    }
+
+    // Intervals between the neighbours of the edited beats change, the old
+    // ones come from the positions before the edit and the new ones from
+    // those after it
+    int first = edit.lead - 1;
+
+    accumulate(edit.before, first, qMin(edit.lead + edit.removed, edit.before.size() - 1), -1);
+    accumulate(edit.after, first, qMin(edit.lead + edit.inserted, edit.after.size() - 1), 1);
+}
+
+void HRVMetrics::clear()
+{
+    shift = 0;
+    count = 0;
+    sum = 0;
+    sumSquares = 0;
+    differences = 0;
+    differenceSquares = 0;
+    above50 = 0;
+}
+
+bool HRVMetrics::isEmpty() const
+{
+    return count == 0;
+}
+
+HRVMetrics::Metrics HRVMetrics::metrics() const
+{
+    Metrics m;
+    m.intervals = count;
+    m.meanRR = 0;
+    m.sdnn = 0;
+    m.rmssd = 0;
+    m.pnn50 = 0;
+    m.meanHR = 0;
+
+    if (count == 0) return m;
+
+    double mean = sum / count;
+
+    m.meanRR = (shift + mean) * 1000;
+    m.meanHR = 60 / (shift + mean);
+
+    if (count > 1)
+    {
+        m.sdnn = qSqrt(qMax(0.0, (sumSquares - sum * mean) / (count - 1))) * 1000;
+    }
+
+    if (differences > 0)
+    {
+        m.rmssd = qSqrt(differenceSquares / differences) * 1000;
+        m.pnn50 = 100.0 * above50 / differences;
+    }
+
+    return m;
+}
+
+void HRVMetrics::accumulate(const QVector<double> &beats, int first, int last, double sign)
+{
+    int n = beats.size();
+    int step = sign > 0 ? 1 : -1;
+
+    // Intervals ending at beats first + 1 to last
+    for (int i = qMax(first + 1, 1); i <= last; i++)
+    {
+        double rr = beats[i] - beats[i - 1] - shift;
+
+        count += step;
+        sum += sign * rr;
+        sumSquares += sign * rr * rr;
+    }
+
+    // Differences of those intervals to the ones before, and of the interval
+    // after them to the last one
+    for (int i = qMax(first + 1, 2); i <= qMin(last + 1, n - 1); i++)
+    {
+        double d = (beats[i] - beats[i - 1]) - (beats[i - 1] - beats[i - 2]);
+
+        differences += step;
+        differenceSquares += sign * d * d;
+
+        if (qAbs(d) > 0.05) above50 += step;
+    }
+}
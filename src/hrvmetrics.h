@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2014-2015 Daniel Gromer
+ *
+ * This file is part of PeakMan.
+ *
+ * PeakMan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * PeakMan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PeakMan.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HRVMETRICS_H
+#define HRVMETRICS_H
+
+#include <QVector>
+#include "peakedit.h"
+
+// Time-domain heart rate variability from running sums over the interbeat
+// intervals and their successive differences. An edit takes the intervals
+// and differences around the edited beats out of the sums and adds the new
+// ones, both taken from the positions around the edit, so every metric is
+// updated in constant time per edited beat.
+class HRVMetrics
+{
+public:
+    struct Metrics
+    {
+        int intervals;
+        double meanRR; // In ms
+        double sdnn; // In ms
+        double rmssd; // In ms
+        double pnn50; // In percent
+        double meanHR; // In beats per minute
+    };
+
+    HRVMetrics();
+
+    void reset(const QVector<double> &peaks); // Peak positions in seconds
+    void update(const QVector<double> &peaks, const PeakEdit &edit); // Peaks after the edit, used if the sums missed an edit
+    void clear();
+
+    bool isEmpty() const;
+    Metrics metrics() const;
+
+private:
+    void accumulate(const QVector<double> &beats, int first, int last, double sign); // Intervals ending at beats (first, last] and their differences
+
+    // Intervals are summed relative to the first interval of the last reset,
+    // keeps the variance from cancelling out after many edits
+    double shift;
+
+    int count;
+    double sum;
+    double sumSquares;
+    int differences;
+    double differenceSquares;
+    int above50; // Successive differences above 50 ms
+};
+
+#endif // HRVMETRICS_H
@@ -0,0 +1,259 @@
+/*
+ * Copyright (C) 2014-2015 Daniel Gromer
+ *
+ * This file is part of PeakMan.
+ *
+ * PeakMan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * PeakMan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PeakMan.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "hrvspectrum.h"
+#include "fft.h"
+#include <qmath.h>
+
+// Grid points each sample is extirpolated to (Lagrange interpolation order)
+static const int Order = 4;
+
+// Grid size relative to the number of frequencies, keeps the extirpolation
+// error of the highest (doubled) frequency small
+static const int GridFactor = 8;
+
+// Frequency bands, in Hz
+static const double VLFLow = 0.0033;
+static const double LFLow = 0.04;
+static const double HFLow = 0.15;
+static const double HFHigh = 0.4;
+
+// Spreads value y at fractional grid position x onto the Order closest grid
+// points, so that sums of y * exp(i * w * x) over the grid equal the sum at x
+static void extirpolate(double y, double x, double *grid, int size)
+{
+    int nearest = qFloor(x);
+
+    if (x == nearest)
+    {
+        grid[nearest % size] += y;
+        return;
+    }
+
+    int first = nearest - Order / 2 + 1;
+    double product = 1;
+
+    for (int m = 0; m < Order; m++)
+    {
+        product *= x - (first + m);
+    }
+
+    for (int m = 0; m < Order; m++)
+    {
+        // Denominator of the Lagrange basis polynomial, prod (m - l) for l != m
+        double denominator = 1;
+
+        for (int l = 0; l < Order; l++)
+        {
+            if (l != m) denominator *= m - l;
+        }
+
+        grid[(first + m + size) % size] += y * product / ((x - (first + m)) * denominator);
+    }
+}
+
+HRVSpectrum::HRVSpectrum()
+{
+    method = LombScargle;
+    oversampling = 4;
+    maxFrequency = 0.5;
+    resampleRate = 4;
+}
+
+void HRVSpectrum::setMethod(Method method)
+{
+    this->method = method;
+}
+
+void HRVSpectrum::setOversampling(double factor)
+{
+    oversampling = factor;
+}
+
+void HRVSpectrum::setMaxFrequency(double frequency)
+{
+    maxFrequency = frequency;
+}
+
+void HRVSpectrum::setResampleRate(double rate)
+{
+    resampleRate = rate;
+}
+
+HRVSpectrum::Result HRVSpectrum::compute(const QVector<double> &intervals) const
+{
+    // Each interval is placed at the beat that ends it
+    QVector<double> time(intervals.size());
+    double t = 0;
+
+    for (int i = 0; i < intervals.size(); i++)
+    {
+        t += intervals[i] / 1000;
+        time[i] = t;
+    }
+
+    Result result = method == LombScargle ? lombScargle(time, intervals) : resampledFFT(time, intervals);
+    bandPowers(result);
+
+    return result;
+}
+
+HRVSpectrum::Result HRVSpectrum::lombScargle(const QVector<double> &time, const QVector<double> &values) const
+{
+    Result result;
+    int n = values.size();
+
+    if (n < 3) return result;
+
+    double span = time.last() - time.first();
+    double step = 1 / (span * oversampling);
+    int frequencies = qFloor(maxFrequency / step);
+
+    if (frequencies < 1) return result;
+
+    double mean = 0;
+
+    for (int i = 0; i < n; i++) mean += values[i];
+
+    mean /= n;
+
+    // The samples go to the real part of the grid, unit weights at doubled
+    // positions (for the 2w sums of the time offset) to the imaginary part,
+    // so one complex FFT serves both
+    int size = FFT::nextPowerOfTwo(GridFactor * frequencies);
+    double scale = step * size;
+
+    QVector<double> re(size, 0);
+    QVector<double> im(size, 0);
+
+    for (int i = 0; i < n; i++)
+    {
+        double x = fmod((time[i] - time.first()) * scale, size);
+
+        extirpolate(values[i] - mean, x, re.data(), size);
+        extirpolate(1, fmod(2 * x, size), im.data(), size);
+    }
+
+    FFT::forward(re, im);
+
+    result.frequency.resize(frequencies);
+    result.power.resize(frequencies);
+
+    // Density normalization: white noise of variance s^2 gives s^2 per bin
+    // spread over the mean Nyquist band n / (2 * span)
+    double density = 2 * span / n;
+
+    for (int k = 1; k <= frequencies; k++)
+    {
+        // Separate the transforms of the two real grids
+        double zr = re[k], zi = im[k];
+        double wr = re[size - k], wi = im[size - k];
+
+        double c = (zr + wr) / 2; // Sum of y * cos(w t)
+        double s = -(zi - wi) / 2; // Sum of y * sin(w t)
+        double c2 = (zi + wi) / 2; // Sum of cos(2 w t)
+        double s2 = (zr - wr) / 2; // Sum of sin(2 w t)
+
+        // Time offset tau that makes the sine and cosine terms orthogonal
+        double hypotenuse = qSqrt(c2 * c2 + s2 * s2);
+        double cos2wt = hypotenuse > 0 ? 0.5 * c2 / hypotenuse : 0.5;
+        double sin2wt = hypotenuse > 0 ? 0.5 * s2 / hypotenuse : 0;
+        double coswt = qSqrt(0.5 + cos2wt);
+        double sinwt = (sin2wt < 0 ? -1 : 1) * qSqrt(qMax(0.0, 0.5 - cos2wt));
+        double den = 0.5 * n + cos2wt * c2 + sin2wt * s2;
+
+        double cterm = den > 0 ? qPow(coswt * c + sinwt * s, 2) / den : 0;
+        double sterm = n - den > 0 ? qPow(coswt * s - sinwt * c, 2) / (n - den) : 0;
+
+        result.frequency[k - 1] = k * step;
+        result.power[k - 1] = 0.5 * (cterm + sterm) * density;
+    }
+
+    return result;
+}
+
+HRVSpectrum::Result HRVSpectrum::resampledFFT(const QVector<double> &time, const QVector<double> &values) const
+{
+    Result result;
+    int n = values.size();
+
+    if (n < 3) return result;
+
+    // Linear interpolation at the resample rate
+    int samples = qFloor((time.last() - time.first()) * resampleRate) + 1;
+    QVector<double> series(samples);
+
+    for (int k = 0, j = 0; k < samples; k++)
+    {
+        double t = time.first() + k / resampleRate;
+
+        while (j + 2 < n && time[j + 1] <= t) j++;
+
+        double w = (t - time[j]) / (time[j + 1] - time[j]);
+        series[k] = values[j] + qBound(0.0, w, 1.0) * (values[j + 1] - values[j]);
+    }
+
+    int size = FFT::nextPowerOfTwo(samples);
+    QVector<double> power = FFT::powerSpectrum(series.constData(), samples, size);
+
+    // One-sided density, corrected for the energy of the Hann window
+    double windowEnergy = 0;
+
+    for (int i = 0; i < samples; i++)
+    {
+        double w = samples > 1 ? 0.5 - 0.5 * qCos(2 * M_PI * i / (samples - 1)) : 1;
+        windowEnergy += w * w;
+    }
+
+    for (int k = 1; k < power.size() - 1; k++)
+    {
+        double frequency = k * resampleRate / size;
+
+        if (frequency > maxFrequency) break;
+
+        result.frequency << frequency;
+        result.power << 2 * power[k] / (resampleRate * windowEnergy);
+    }
+
+    return result;
+}
+
+void HRVSpectrum::bandPowers(Result &result)
+{
+    result.vlf = 0;
+    result.lf = 0;
+    result.hf = 0;
+
+    int n = result.frequency.size();
+
+    if (n < 2) return;
+
+    // Bins are evenly spaced, integrate with the bin width
+    double width = result.frequency[1] - result.frequency[0];
+
+    for (int k = 0; k < n; k++)
+    {
+        double f = result.frequency[k];
+        double p = result.power[k] * width;
+
+        if (f >= VLFLow && f < LFLow) result.vlf += p;
+        else if (f >= LFLow && f < HFLow) result.lf += p;
+        else if (f >= HFLow && f < HFHigh) result.hf += p;
+    }
+}
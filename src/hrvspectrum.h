@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2014-2015 Daniel Gromer
+ *
+ * This file is part of PeakMan.
+ *
+ * PeakMan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * PeakMan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PeakMan.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HRVSPECTRUM_H
+#define HRVSPECTRUM_H
+
+#include <QVector>
+
+// Power spectrum of the interbeat interval series, with the usual HRV band
+// powers. The intervals are unevenly spaced in time, so the main estimate is
+// the Lomb-Scargle periodogram. It is computed with the fast method of Press
+// and Rybicki: the samples are extirpolated onto a regular grid and all
+// trigonometric sums come from FFTs, O(N log N) instead of O(N * F). The FFT
+// of an evenly resampled series is available for comparison.
+class HRVSpectrum
+{
+public:
+    enum Method { LombScargle, ResampledFFT };
+
+    struct Result
+    {
+        QVector<double> frequency; // In Hz
+        QVector<double> power; // Power spectral density, in ms^2 / Hz
+        double vlf; // Band powers, in ms^2
+        double lf;
+        double hf;
+    };
+
+    HRVSpectrum();
+
+    void setMethod(Method method);
+    void setOversampling(double factor); // Of the Lomb-Scargle frequency grid
+    void setMaxFrequency(double frequency);
+    void setResampleRate(double rate); // For the FFT method
+
+    Result compute(const QVector<double> &intervals) const; // In ms, as in the IBI plot
+
+private:
+    Result lombScargle(const QVector<double> &time, const QVector<double> &values) const;
+    Result resampledFFT(const QVector<double> &time, const QVector<double> &values) const;
+    static void bandPowers(Result &result);
+
+    Method method;
+    double oversampling;
+    double maxFrequency;
+    double resampleRate;
+};
+
+#endif // HRVSPECTRUM_H
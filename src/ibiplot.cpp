@@ -23,9 +23,36 @@ IBIPlot::IBIPlot(QWidget *parent) : QCustomPlot(parent)
 {
     setFocusPolicy(Qt::ClickFocus);
 
+    // Only the artifact graphs go to the legend, when comparing methods
+    setAutoAddPlottableToLegend(false);
+    legend->setFont(QFont(font().family(), 8));
+    compareArtifacts = false;
+    histogram = 0;
+
     // Initialize graphs
     ibi = addGraph();
     artifacts = addGraph();
+    artifacts->setPen(Qt::NoPen);
+    artifacts->setScatterStyle(QCPScatterStyle(QCPScatterStyle::ssCircle, QColor(200, 40, 41), QColor(200, 40, 41), 7));
+
+    QCPScatterStyle::ScatterShape shapes[] = { QCPScatterStyle::ssCross, QCPScatterStyle::ssSquare, QCPScatterStyle::ssDiamond };
+    QColor colors[] = { QColor(137, 89, 168), QColor(62, 153, 159), QColor(234, 183, 0) };
+
+    for (int m = 0; m < ArtifactDetector::methodCount(); m++)
+    {
+        QCPGraph *graph = addGraph();
+        graph->setPen(Qt::NoPen);
+        graph->setScatterStyle(QCPScatterStyle(shapes[m % 3], colors[m % 3], 11));
+        comparison << graph;
+    }
+
+    respiration = addGraph(xAxis, yAxis2);
+    respiration->setPen(QPen(QColor(62, 153, 159)));
+
+    // Respiration is kept in the lower part of the plot, below the intervals
+    yAxis2->setLabel("Respiration (EDR)");
+    yAxis2->setRange(-4, 12);
+    yAxis2->setTickLabels(false);
 
     // Initialize tracer
     selection = new QCPItemTracer(this);
@@ -104,25 +131,19 @@ double IBIPlot::getReferenceInterval()
 }
 
 // Compute interbeat intervals from peak positions
-void IBIPlot::computeInterbeatIntervals(QLinkedList<QCPItemStraightLine*> peaks)
+void IBIPlot::computeInterbeatIntervals(QVector<double> peaks)
 {
     clear();
 
-    double lastPeakPosition = peaks.first()->point1->key() * 1000;
-    int i = 0;
+    ibi_x.resize(peaks.size() - 1);
+    ibi_y.resize(peaks.size() - 1);
 
     // Compute interbeat intervals in msec
-    foreach (QCPItemStraightLine *peak, peaks)
+    for (int i = 1; i < peaks.size(); i++)
     {
-        ibi_x << (double) i++;
-        ibi_y << peak->point1->key() * 1000 - lastPeakPosition;
-
-        lastPeakPosition += ibi_y.last();
+        ibi_x[i - 1] = (double) i;
+        ibi_y[i - 1] = peaks[i] * 1000 - peaks[i - 1] * 1000;
     }
-
-    // First element is zero
-    ibi_x.removeFirst();
-    ibi_y.removeFirst();
 }
 
 void IBIPlot::plot(QVector<double> x, QVector<double> y, bool set_range)
@@ -155,6 +176,7 @@ void IBIPlot::clear()
     ibi_y.clear();
 
     clearArtifacts();
+    clearRespiration();
     unsetTracer();
 
     replot();
@@ -163,28 +185,70 @@ void IBIPlot::clear()
 void IBIPlot::plotArtifacts(QVector<double> x, QVector<double> y)
 {
     artifacts->setData(x, y);
-    artifacts->setPen(Qt::NoPen);
-    artifacts->setScatterStyle(QCPScatterStyle(QCPScatterStyle::ssCircle, QColor(200, 40, 41), QColor(200, 40, 41), 7));
     replot();
 }
 
 void IBIPlot::clearArtifacts()
 {
     artifacts->clearData();
+    artifactIndices.clear();
+
+    for (int m = 0; m < comparison.size(); m++)
+    {
+        comparison[m]->clearData();
+        comparison[m]->removeFromLegend();
+    }
+
+    artifacts->removeFromLegend();
+    legend->setVisible(false);
 }
 
-double IBIPlot::getMaxIbi()
+void IBIPlot::setRespiration(const QVector<double> &values, double rate, const QVector<double> &peaks)
 {
-    double maxIbi = 0;
-
-    QList<QCPData> data = ibi->data()->values();
+    QVector<double> x;
+    QVector<double> y;
 
-    for (int i = 0; i < data.size(); i++)
+    if (peaks.size() > 1)
     {
-        maxIbi = qMax(maxIbi, data[i].value);
+        // The x-axis counts beats, interval i ends at peak i. Samples between
+        // two peaks are placed in between their intervals.
+        int j = 0;
+        int first = qCeil(peaks[1] * rate);
+        int last = qMin(values.size() - 1, qFloor(peaks.last() * rate));
+
+        for (int k = first; k <= last; k++)
+        {
+            double t = k / rate;
+
+            while (j + 2 < peaks.size() && peaks[j + 1] <= t) j++;
+
+            x << j + (t - peaks[j]) / (peaks[j + 1] - peaks[j]);
+            y << values[k];
+        }
     }
 
-    return maxIbi;
+    respiration->setData(x, y);
+    yAxis2->setVisible(!x.isEmpty());
+
+    replot();
+}
+
+void IBIPlot::clearRespiration()
+{
+    respiration->clearData();
+    yAxis2->setVisible(false);
+}
+
+void IBIPlot::setHistogram(const IntervalHistogram *histogram)
+{
+    this->histogram = histogram;
+}
+
+double IBIPlot::getMaxIbi()
+{
+    if (ibi_y.isEmpty() || !histogram) return 0;
+
+    return histogram->maximum();
 }
 
 QVector<double> IBIPlot::getIbi_y()
@@ -192,29 +256,113 @@ QVector<double> IBIPlot::getIbi_y()
     return ibi_y;
 }
 
-void IBIPlot::setup(QLinkedList<QCPItemStraightLine *> peaks, bool set_range)
+QVector<int> IBIPlot::getArtifacts() const
+{
+    return artifactIndices;
+}
+
+void IBIPlot::setup(QVector<double> peaks, bool set_range)
 {
     computeInterbeatIntervals(peaks);
     plot(ibi_x, ibi_y, set_range);
     setTracer();
-    emit setupHistPlot(ibi_y, getMaxIbi());
+    emit setupHistPlot();
+}
+
+void IBIPlot::setupFromIntervals(QVector<double> intervals)
+{
+    clear();
+
+    ibi_y = intervals;
+    ibi_x.resize(ibi_y.size());
+
+    // Same numbering as in computeInterbeatIntervals()
+    for (int i = 0; i < ibi_x.size(); i++)
+    {
+        ibi_x[i] = i + 1;
+    }
+
+    plot(ibi_x, ibi_y);
+    setTracer();
+    emit setupHistPlot();
 }
 
 void IBIPlot::artifactDetection()
 {
+    clearArtifacts();
+
+    QVector<int> found = detector.detect(ibi_y);
+    artifactIndices = found;
+
     QVector<double> artifacts_x;
     QVector<double> artifacts_y;
 
-    for (int i = 1; i < ibi_y.size(); i++)
+    for (int i = 0; i < found.size(); i++)
+    {
+        artifacts_x << ibi_x[found[i]];
+        artifacts_y << ibi_y[found[i]];
+    }
+
+    QString summary = QString("%1: %2 artifacts").arg(ArtifactDetector::methodName(detector.getMethod())).arg(found.size());
+
+    if (compareArtifacts)
     {
-        if (qAbs(ibi_y[i] - ibi_y[i - 1]) > .2 * ibi_y[i - 1])
+        // Flags of every method per interval, for the artifacts they agree on
+        QVector<int> flags(ibi_y.size(), 0);
+
+        for (int i = 0; i < found.size(); i++) flags[found[i]]++;
+
+        for (int m = 0; m < comparison.size(); m++)
         {
-            artifacts_x << ibi_x[i];
-            artifacts_y << ibi_y[i];
+            if (m == detector.getMethod()) continue;
+
+            ArtifactDetector other;
+            other.setMethod((ArtifactDetector::Method) m);
+            QVector<int> otherFound = other.detect(ibi_y);
+
+            QVector<double> x(otherFound.size());
+            QVector<double> y(otherFound.size());
+
+            for (int i = 0; i < otherFound.size(); i++)
+            {
+                x[i] = ibi_x[otherFound[i]];
+                y[i] = ibi_y[otherFound[i]];
+                flags[otherFound[i]]++;
+            }
+
+            comparison[m]->setData(x, y);
+            comparison[m]->setName(QString("%1 (%2)").arg(ArtifactDetector::methodName(other.getMethod())).arg(otherFound.size()));
+            comparison[m]->addToLegend();
+
+            summary += QString(", %1: %2").arg(ArtifactDetector::methodName(other.getMethod())).arg(otherFound.size());
         }
+
+        int agreed = flags.count(comparison.size());
+
+        artifacts->setName(QString("%1 (%2)").arg(ArtifactDetector::methodName(detector.getMethod())).arg(found.size()));
+        artifacts->addToLegend();
+        legend->setVisible(true);
+
+        summary += QString(", %1 found by all").arg(agreed);
     }
 
     plotArtifacts(artifacts_x, artifacts_y);
+
+    emit artifactsDetected(summary);
+}
+
+void IBIPlot::setArtifactMethod(int method)
+{
+    detector.setMethod((ArtifactDetector::Method) method);
+
+    if (!ibi_y.isEmpty()) artifactDetection();
+}
+
+void IBIPlot::setCompareArtifacts(bool compare)
+{
+    compareArtifacts = compare;
+
+    if (!ibi_y.isEmpty()) artifactDetection();
 }
 
 // TODO: improve selecting mechanism here: should also look at y-position of click (maybe nearest point of ibi line)
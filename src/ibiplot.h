@@ -21,6 +21,8 @@
 #define IBIPLOT_H
 
 #include "qcustomplot.h"
+#include "artifactdetector.h"
+#include "intervalhistogram.h"
 
 class IBIPlot : public QCustomPlot
 {
@@ -36,26 +38,34 @@ public:
     double getSelectionPosY();
     double getSelectionTimePoint();
     double getReferenceInterval();
-    void computeInterbeatIntervals(QLinkedList<QCPItemStraightLine *> peaks);
-    void setup(QLinkedList<QCPItemStraightLine *> peaks, bool set_range = true);
+    void computeInterbeatIntervals(QVector<double> peaks);
+    void setup(QVector<double> peaks, bool set_range = true);
+    void setupFromIntervals(QVector<double> intervals); // Used for interbeat interval files without ecg
     //void update(QLinkedList<QCPItemStraightLine *> peaks);
     void plot(QVector<double> x, QVector<double> y, bool set_range = true);
     void clear();
     void plotArtifacts(QVector<double> x, QVector<double> y);
     void clearArtifacts();
-    double getMaxIbi();
+    void setRespiration(const QVector<double> &values, double rate, const QVector<double> &peaks); // Evenly sampled series, aligned to the beats
+    void clearRespiration();
+    void setHistogram(const IntervalHistogram *histogram); // Of the shown intervals, kept up to date by the owner
+    double getMaxIbi(); // O(log bins), see IntervalHistogram
 
     QVector<double> getIbi_y();
+    QVector<int> getArtifacts() const; // Indices of the intervals flagged by the last detection
 
 public slots:
     void artifactDetection(); // Search for artifacts in sequence of interbeat intervals
+    void setArtifactMethod(int method); // ArtifactDetector::Method
+    void setCompareArtifacts(bool compare); // Also show the artifacts of the other methods
     void resetView();
 
 signals:
     void ibiSelected(bool);
     void ibiSelectedDoubleClick();
     void ibiSelectedInsertMissingPeaks();
-    void setupHistPlot(QVector<double>, double);
+    void setupHistPlot();
+    void artifactsDetected(QString summary); // Artifacts found per method
 
 private slots:
     void mousePressEvent(QMouseEvent *event);
@@ -68,8 +78,15 @@ private:
     QCPGraph *ibi;
     QVector<double> ibi_x;
     QVector<double> ibi_y;
+    const IntervalHistogram *histogram; // Largest interval without going through the plot data
 
     QCPGraph *artifacts;
+    QVector<int> artifactIndices;
+    QVector<QCPGraph *> comparison; // One per method, the selected one stays empty
+    ArtifactDetector detector;
+    bool compareArtifacts;
+
+    QCPGraph *respiration; // On the right axis
 };
 
 #endif // IBIPLOT_H
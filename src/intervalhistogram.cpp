@@ -0,0 +1,360 @@
+/*
+ * Copyright (C) 2014-2015 Daniel Gromer
+ *
+ * This file is part of PeakMan.
+ *
+ * PeakMan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * PeakMan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PeakMan.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "intervalhistogram.h"
+#include "fft.h"
+#include <QtAlgorithms>
+#include <QtNumeric>
+#include <qmath.h>
+#include <cmath>
+
+// The kernel is cut off at this many bandwidths
+static const double KernelExtent = 4;
+
+// Base bins cover intervals up to 16.4 s, far beyond any heart rate
+static const int MaxBins = 16384;
+
+IntervalHistogram::IntervalHistogram()
+{
+    grow(0);
+    clear();
+}
+
+void IntervalHistogram::reset(const QVector<double> &peaks)
+{
+    clear();
+
+    accumulate(peaks, 1, peaks.size() - 1, 1);
+}
+
+void IntervalHistogram::resetFromIntervals(const QVector<double> &intervals)
+{
+    clear();
+
+    for (int i = 0; i < intervals.size(); i++)
+    {
+        add(intervals[i]);
+    }
+}
+
+void IntervalHistogram::update(const QVector<double> &peaks, const PeakEdit &edit)
+{
+    // The bins missed an edit, start over
+    if (total != qMax(edit.sizeBefore() - 1, 0) || peaks.size() != edit.peaks)
+    {
+        reset(peaks);
+        return;
+    }
+
+    // Intervals ending at the replaced beats and at the beat after them
+    int first = qMax(edit.lead, 1);
+
+    accumulate(edit.before, first, qMin(edit.lead + edit.removed, edit.before.size() - 1), -1);
+    accumulate(edit.after, first, qMin(edit.lead + edit.inserted, edit.after.size() - 1), 1);
+}
+
+void IntervalHistogram::add(double interval)
+{
+    if (!qIsFinite(interval) || interval < 0) return;
+
+    total++;
+
+    if (interval >= MaxBins)
+    {
+        outliers.insert(qLowerBound(outliers.constBegin(), outliers.constEnd(), interval) - outliers.constBegin(), interval);
+        return;
+    }
+
+    sum += interval;
+    sumSquares += interval * interval;
+
+    int bin = qFloor(interval);
+
+    if (bin >= base.size()) grow(bin + 1);
+
+    base[bin]++;
+
+    for (int node = base.size() + bin; node > 0; node /= 2)
+    {
+        tree[node]++;
+    }
+}
+
+void IntervalHistogram::remove(double interval)
+{
+    if (!qIsFinite(interval) || interval < 0) return;
+
+    if (interval >= MaxBins)
+    {
+        int i = qLowerBound(outliers.constBegin(), outliers.constEnd(), interval) - outliers.constBegin();
+
+        if (i == outliers.size() || outliers[i] != interval) return;
+
+        outliers.remove(i);
+        total--;
+        return;
+    }
+
+    int bin = qFloor(interval);
+
+    if (bin >= base.size() || base[bin] <= 0) return;
+
+    base[bin]--;
+
+    for (int node = base.size() + bin; node > 0; node /= 2)
+    {
+        tree[node]--;
+    }
+
+    total--;
+    sum -= interval;
+    sumSquares -= interval * interval;
+}
+
+void IntervalHistogram::clear()
+{
+    base.fill(0);
+    tree.fill(0);
+    outliers.clear();
+    total = 0;
+    sum = 0;
+    sumSquares = 0;
+}
+
+bool IntervalHistogram::isEmpty() const
+{
+    return total == 0;
+}
+
+int IntervalHistogram::count() const
+{
+    return total;
+}
+
+double IntervalHistogram::minimum() const
+{
+    if (total == 0) return 0;
+
+    if (tree[1] == 0) return std::floor(outliers.first());
+
+    // Leftmost leaf with a count
+    int node = 1;
+
+    while (node < base.size())
+    {
+        node = tree[2 * node] > 0 ? 2 * node : 2 * node + 1;
+    }
+
+    return node - base.size();
+}
+
+double IntervalHistogram::maximum() const
+{
+    if (!outliers.isEmpty()) return std::floor(outliers.last()) + 1;
+
+    return occupied();
+}
+
+int IntervalHistogram::occupied() const
+{
+    if (tree[1] == 0) return 0;
+
+    // Rightmost leaf with a count
+    int node = 1;
+
+    while (node < base.size())
+    {
+        node = tree[2 * node + 1] > 0 ? 2 * node + 1 : 2 * node;
+    }
+
+    return node - base.size() + 1;
+}
+
+void IntervalHistogram::accumulate(const QVector<double> &beats, int first, int last, int sign)
+{
+    // Same as the intervals of the interbeat interval plot, so that removed
+    // intervals hit the bins they were added to
+    for (int i = first; i <= last; i++)
+    {
+        double interval = beats[i] * 1000 - beats[i - 1] * 1000;
+
+        if (sign > 0)
+        {
+            add(interval);
+        }
+        else
+        {
+            remove(interval);
+        }
+    }
+}
+
+void IntervalHistogram::grow(int bins)
+{
+    // Powers of two keep the tree complete, leaves at [size, 2 * size)
+    int size = qMax(1024, base.size());
+
+    while (size < qMin(bins, MaxBins)) size *= 2;
+
+    base.resize(size);
+    tree.fill(0, 2 * size);
+
+    for (int i = 0; i < size; i++)
+    {
+        tree[size + i] = base[i];
+    }
+
+    for (int node = size - 1; node > 0; node--)
+    {
+        tree[node] = tree[2 * node] + tree[2 * node + 1];
+    }
+}
+
+void IntervalHistogram::binned(int binWidth, QVector<double> &x, QVector<double> &y) const
+{
+    binWidth = qMax(1, binWidth);
+
+    int size = occupied();
+    int bins = (size + binWidth - 1) / binWidth;
+
+    x.resize(bins);
+    y.fill(0, bins);
+
+    for (int b = 0; b < bins; b++)
+    {
+        x[b] = b * binWidth + binWidth / 2.0;
+    }
+
+    for (int i = 0; i < size; i++)
+    {
+        y[i / binWidth] += base[i];
+    }
+}
+
+void IntervalHistogram::density(int binWidth, QVector<double> &x, QVector<double> &y, double bandwidth) const
+{
+    x.clear();
+    y.clear();
+
+    if (total == 0) return;
+
+    if (bandwidth <= 0) bandwidth = silvermanBandwidth();
+
+    // Also bounds the padding when outliers blow up the spread
+    bandwidth = qBound(1.0, bandwidth, (double) MaxBins);
+
+    int size = occupied();
+
+    // Zero padding past the kernel on both sides keeps the circular
+    // convolution from wrapping around
+    int extent = qCeil(KernelExtent * bandwidth);
+    int n = FFT::nextPowerOfTwo(size + 2 * extent);
+
+    QVector<double> re(n, 0), im(n, 0);
+    QVector<double> kernelRe(n, 0), kernelIm(n, 0);
+
+    for (int i = 0; i < size; i++)
+    {
+        re[i + extent] = base[i];
+    }
+
+    // Kernel centered at 0, wrapped to the end for negative offsets
+    double norm = 1 / (qSqrt(2 * M_PI) * bandwidth);
+
+    for (int k = -extent; k <= extent; k++)
+    {
+        kernelRe[(k + n) % n] = norm * qExp(-0.5 * (k / bandwidth) * (k / bandwidth));
+    }
+
+    FFT::forward(re, im);
+    FFT::forward(kernelRe, kernelIm);
+
+    for (int i = 0; i < n; i++)
+    {
+        double r = re[i] * kernelRe[i] - im[i] * kernelIm[i];
+        double m = re[i] * kernelIm[i] + im[i] * kernelRe[i];
+        re[i] = r;
+        im[i] = m;
+    }
+
+    FFT::inverse(re, im);
+
+    // Counts per ms, scaled to counts per bin of the histogram
+    int points = size + 2 * extent;
+    x.resize(points);
+    y.resize(points);
+
+    for (int i = 0; i < points; i++)
+    {
+        x[i] = i - extent + 0.5;
+        y[i] = qMax(0.0, re[i]) * binWidth;
+    }
+}
+
+double IntervalHistogram::silvermanBandwidth() const
+{
+    if (total < 2) return 10;
+
+    // The few intervals past the base bins are not in the running sums
+    double allSum = sum, allSquares = sumSquares;
+
+    for (int i = 0; i < outliers.size(); i++)
+    {
+        allSum += outliers[i];
+        allSquares += outliers[i] * outliers[i];
+    }
+
+    double mean = allSum / total;
+    double sd = qSqrt(qMax(0.0, (allSquares - allSum * mean) / (total - 1)));
+
+    // The interquartile range keeps artifacts from widening the kernel
+    double spread = (quantile(0.75) - quantile(0.25)) / 1.34;
+
+    if (spread > 0 && !(sd > 0 && sd < spread)) sd = spread;
+
+    return 0.9 * sd * qPow(total, -0.2);
+}
+
+double IntervalHistogram::quantile(double fraction) const
+{
+    int size = occupied();
+    double wanted = fraction * total;
+    double cumulated = 0;
+
+    for (int i = 0; i < size; i++)
+    {
+        if (cumulated + base[i] >= wanted && base[i] > 0)
+        {
+            // Spread evenly within the base bin
+            return i + (wanted - cumulated) / base[i];
+        }
+
+        cumulated += base[i];
+    }
+
+    // Falls among the intervals past the base bins
+    for (int i = 0; i < outliers.size(); i++)
+    {
+        if (cumulated + 1 >= wanted) return outliers[i];
+
+        cumulated++;
+    }
+
+    return size;
+}
@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2014-2015 Daniel Gromer
+ *
+ * This file is part of PeakMan.
+ *
+ * PeakMan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * PeakMan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PeakMan.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef INTERVALHISTOGRAM_H
+#define INTERVALHISTOGRAM_H
+
+#include <QVector>
+#include "peakedit.h"
+
+// Histogram of interbeat intervals kept in 1 ms base bins. Histograms of any
+// bin width are summed from the base bins, and the kernel density estimate is
+// a convolution of the base bins with a Gaussian via FFT, so neither depends
+// on the number of intervals once they are binned.
+//
+// An edit of the peaks takes the intervals around the edited beats out of the
+// bins and adds the new ones, both from the positions around the edit. A
+// segment tree over the bin counts gives the smallest and largest interval in
+// O(log bins).
+//
+// The base bins stop at a fixed maximum interval. Longer intervals, from gaps
+// in the peaks or corrupt interval files, are kept as values outside the bins
+// so that they still count in the statistics and the maximum.
+class IntervalHistogram
+{
+public:
+    IntervalHistogram();
+
+    void reset(const QVector<double> &peaks); // Peak positions in seconds
+    void resetFromIntervals(const QVector<double> &intervals); // In ms, for interval files without peaks
+    void update(const QVector<double> &peaks, const PeakEdit &edit); // Peaks after the edit, used if the bins missed an edit
+    void add(double interval);
+    void remove(double interval); // Interval must have been added
+    void clear();
+
+    bool isEmpty() const;
+    int count() const;
+    double minimum() const; // Lower edge of the first occupied base bin
+    double maximum() const; // Upper edge of the last occupied base bin
+
+    // Bins of binWidth ms, x at the bin centers, up to the last occupied base
+    // bin
+    void binned(int binWidth, QVector<double> &x, QVector<double> &y) const;
+
+    // Gaussian kernel density in the same units as binned() counts of
+    // binWidth, evaluated at the base bin centers. Bandwidth 0 picks one by
+    // Silverman's rule.
+    void density(int binWidth, QVector<double> &x, QVector<double> &y, double bandwidth = 0) const;
+
+    double silvermanBandwidth() const;
+
+private:
+    void accumulate(const QVector<double> &beats, int first, int last, int sign); // Intervals ending at beats [first, last]
+    double quantile(double fraction) const;
+    void grow(int bins); // Base bins and tree cover at least bins
+    int occupied() const; // Base bins up to the last occupied one
+
+    QVector<double> base; // Counts of [i, i + 1) ms
+    QVector<int> tree; // Counts of the base bins below each node, leaves from index base.size()
+    QVector<double> outliers; // Sorted intervals past the base bins
+    int total;
+    double sum; // Of the intervals in the base bins
+    double sumSquares;
+};
+
+#endif // INTERVALHISTOGRAM_H
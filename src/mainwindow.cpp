@@ -20,6 +20,7 @@
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
 #include <QDebug>
+#include <QtNumeric>
 
 MainWindow::MainWindow(QWidget *parent) :
     QMainWindow(parent),
@@ -30,11 +31,43 @@ MainWindow::MainWindow(QWidget *parent) :
     // Allow drag and drop from windows explorer
     setAcceptDrops(true);
 
+    // Recordings dropped together are loaded in the background
+    sessionQueue = new SessionQueue(this);
+
+    // Analysis panels are hidden until opened from the view menu
+    ui->ensembleDock->hide();
+    ui->menuView->addAction(ui->ensembleDock->toggleViewAction());
+    ui->hrvDock->hide();
+    ui->menuView->addAction(ui->hrvDock->toggleViewAction());
+    ui->spectrumDock->hide();
+    ui->menuView->addAction(ui->spectrumDock->toggleViewAction());
+    ui->trendDock->hide();
+    ui->menuView->addAction(ui->trendDock->toggleViewAction());
+    ui->poincareDock->hide();
+    ui->menuView->addAction(ui->poincareDock->toggleViewAction());
+    ui->reviewDock->hide();
+    ui->menuView->addAction(ui->reviewDock->toggleViewAction());
+    connect(ui->menuShowHeartRate, SIGNAL(toggled(bool)), ui->ecgPlot, SLOT(setHeartRateVisible(bool)));
+
+    // Signal quality is assessed in the background after a file is opened
+    qualityWatcher = new QFutureWatcher<SignalQuality::Segment>(this);
+    connect(qualityWatcher, SIGNAL(resultsReadyAt(int,int)), this, SLOT(showSignalQuality(int,int)));
+    connect(qualityWatcher, SIGNAL(finished()), this, SLOT(signalQualityFinished()));
+
+    // Thumbnails of the artifact review queue are rendered in the background as well
+    thumbnailWatcher = new QFutureWatcher<QImage>(this);
+    connect(thumbnailWatcher, SIGNAL(resultsReadyAt(int,int)), this, SLOT(showThumbnails(int,int)));
+    connect(thumbnailWatcher, SIGNAL(finished()), this, SLOT(renderThumbnails()));
+
     // Create connections for menu items
     connect(ui->menuOpenFile, SIGNAL(triggered()), this, SLOT(getFileName()));
+    connect(ui->menuOpenNextFile, SIGNAL(triggered()), this, SLOT(openNextFile()));
     connect(ui->menuCloseCurrentFile, SIGNAL(triggered()), this, SLOT(closeCurrentFile()));
+    connect(ui->menuInvertSignal, SIGNAL(triggered()), this, SLOT(invertSignal()));
     connect(ui->menuSavePeakPositions, SIGNAL(triggered()), this, SLOT(savePeakPositions()));
+    connect(ui->menuSaveBeatFeatures, SIGNAL(triggered()), this, SLOT(saveBeatFeatures()));
     connect(ui->menuSaveInterbeatIntervals, SIGNAL(triggered()), this, SLOT(saveInterbeatIntervals()));
+    connect(ui->menuSaveHeartRate, SIGNAL(triggered()), this, SLOT(saveHeartRate()));
     connect(ui->menuAboutPeakMan, SIGNAL(triggered(bool)), this, SLOT(aboutPeakMan()));
 
     // Configure scroll bars
@@ -46,6 +79,10 @@ MainWindow::MainWindow(QWidget *parent) :
     connect(ui->horizontalScrollBar, SIGNAL(valueChanged(int)), this, SLOT(horzScrollBarChanged(int)));
     connect(ui->ecgPlot->xAxis, SIGNAL(rangeChanged(QCPRange)), this, SLOT(xAxisChanged(QCPRange)));
     connect(ui->ecgPlot->yAxis, SIGNAL(rangeChanged(QCPRange)), this, SLOT(yAxisChanged(QCPRange)));
+
+    // The trend plot shares the time axis of the ecg plot
+    connect(ui->ecgPlot->xAxis, SIGNAL(rangeChanged(QCPRange)), ui->trendPlot, SLOT(setTimeRange(QCPRange)));
+    connect(ui->trendPlot->xAxis, SIGNAL(rangeChanged(QCPRange)), this, SLOT(trendRangeChanged(QCPRange)));
     connect(ui->verticalSlider, SIGNAL(valueChanged(int)), this, SLOT(vertSliderChanged(int)));
 
     // Initialize axis range (and scroll bar positions via signals we just connected):
@@ -57,25 +94,86 @@ MainWindow::MainWindow(QWidget *parent) :
     connect(ui->showGlobalThresholdCheckBox, SIGNAL(toggled(bool)), ui->ecgPlot, SLOT(setGlobalThresholdLineVisible(bool)));
     connect(ui->ecgPlot, SIGNAL(globalThresholdChanged(int)), ui->globalThresholdSpinBox, SLOT(setValue(int)));
 
+    // Baseline removal and filter stage
+    connect(ui->removeBaselineCheckBox, SIGNAL(toggled(bool)), this, SLOT(updateFilter()));
+    connect(ui->showBaselineCheckBox, SIGNAL(toggled(bool)), ui->ecgPlot, SLOT(setBaselineVisible(bool)));
+    connect(ui->filterGroupBox, SIGNAL(toggled(bool)), this, SLOT(updateFilter()));
+
+    connect(ui->highPassSpinBox, SIGNAL(editingFinished()), this, SLOT(updateFilter()));
+    connect(ui->lowPassSpinBox, SIGNAL(editingFinished()), this, SLOT(updateFilter()));
+    connect(ui->notchComboBox, SIGNAL(currentIndexChanged(int)), this, SLOT(updateFilter()));
+
+    // Signal quality
+    connect(ui->showQualityCheckBox, SIGNAL(toggled(bool)), ui->ecgPlot, SLOT(setQualityShadingVisible(bool)));
+    connect(ui->skipUnusableCheckBox, SIGNAL(toggled(bool)), ui->ecgPlot, SLOT(setSkipUnusableSegments(bool)));
+
     // Peak detection
+    connect(ui->classifyBeatsButton, SIGNAL(clicked()), this, SLOT(classifyBeats()));
+    connect(ui->colorPeaksComboBox, SIGNAL(currentIndexChanged(int)), this, SLOT(colorPeaks(int)));
+    connect(ui->averageBeatsButton, SIGNAL(clicked()), this, SLOT(averageBeats()));
+    connect(ui->saveEnsembleButton, SIGNAL(clicked()), this, SLOT(saveEnsembleAverage()));
+    connect(ui->computeSpectrumButton, SIGNAL(clicked()), this, SLOT(computeSpectrum()));
+    connect(ui->computeNonlinearButton, SIGNAL(clicked()), this, SLOT(computeNonlinear()));
+    connect(ui->computeTrendButton, SIGNAL(clicked()), this, SLOT(computeTrend()));
+    connect(ui->saveTrendButton, SIGNAL(clicked()), this, SLOT(saveTrend()));
     connect(ui->detectPeaksButton, SIGNAL(clicked()), this, SLOT(peakDetection()));
 
     // Update interbeat intervals
     connect(ui->updateIbiButton, SIGNAL(clicked()), this, SLOT(setupIbiPlot()));
-    connect(ui->ibiPlot, SIGNAL(setupHistPlot(QVector<double>, double)), ui->histPlot, SLOT(setup(QVector<double>, double)));
+    connect(ui->ibiPlot, SIGNAL(setupHistPlot()), ui->histPlot, SLOT(setup()));
+    connect(ui->histBinWidthSpinBox, SIGNAL(valueChanged(int)), ui->histPlot, SLOT(setBinWidth(int)));
+    connect(ui->showDensityCheckBox, SIGNAL(toggled(bool)), ui->histPlot, SLOT(setDensityVisible(bool)));
     connect(ui->ecgPlot, SIGNAL(peaksChanged()), this, SLOT(setupIbiPlot()));
 
+    // One interval histogram for the histogram plot and the interval plot range
+    ui->ibiPlot->setHistogram(&histogram);
+    ui->histPlot->setHistogram(&histogram);
+    connect(ui->ecgPlot, SIGNAL(peaksEdited(PeakEdit)), this, SLOT(updateHistogram(PeakEdit)));
+    connect(ui->ecgPlot, SIGNAL(peaksReset()), this, SLOT(resetHistogram()));
+
+    // Ecg-derived respiration follows the peaks
+    connect(ui->ecgPlot, SIGNAL(peaksEdited(PeakEdit)), this, SLOT(updateRespiration(PeakEdit)));
+    connect(ui->ecgPlot, SIGNAL(peaksReset()), this, SLOT(resetRespiration()));
+    connect(ui->showRespirationCheckBox, SIGNAL(toggled(bool)), this, SLOT(resetRespiration()));
+
+    // Evenly resampled heart rate as well
+    connect(ui->ecgPlot, SIGNAL(peaksEdited(PeakEdit)), this, SLOT(updateHeartRate(PeakEdit)));
+    connect(ui->ecgPlot, SIGNAL(peaksReset()), this, SLOT(resetHeartRate()));
+
+    // Live heart rate variability while correcting peaks
+    connect(ui->ecgPlot, SIGNAL(peaksEdited(PeakEdit)), this, SLOT(updateHrvMetrics(PeakEdit)));
+    connect(ui->ecgPlot, SIGNAL(peaksReset()), this, SLOT(resetHrvMetrics()));
+
+    // Poincaré density and its SD1, SD2 too
+    connect(ui->ecgPlot, SIGNAL(peaksEdited(PeakEdit)), this, SLOT(updatePoincare(PeakEdit)));
+    connect(ui->ecgPlot, SIGNAL(peaksReset()), this, SLOT(resetPoincare()));
+
     // Apply correction button and jump to position button
     connect(ui->artifactDetectionPushButton, SIGNAL(clicked()), ui->ibiPlot, SLOT(artifactDetection()));
+    connect(ui->artifactMethodComboBox, SIGNAL(currentIndexChanged(int)), ui->ibiPlot, SLOT(setArtifactMethod(int)));
+    connect(ui->compareArtifactsCheckBox, SIGNAL(toggled(bool)), ui->ibiPlot, SLOT(setCompareArtifacts(bool)));
+    connect(ui->ibiPlot, SIGNAL(artifactsDetected(QString)), this, SLOT(showArtifactSummary(QString)));
     connect(ui->insertMissingPeaksButton, SIGNAL(clicked()), this, SLOT(insertMissingPeaks()));
+    connect(ui->correctAllArtifactsButton, SIGNAL(clicked()), this, SLOT(correctAllArtifacts()));
+    connect(ui->startReviewButton, SIGNAL(clicked()), this, SLOT(startReview()));
+    connect(ui->correctAcceptedButton, SIGNAL(clicked()), this, SLOT(correctAccepted()));
+    connect(ui->artifactReview, SIGNAL(decisionsChanged()), this, SLOT(reviewDecisionsChanged()));
+    connect(ui->artifactReview, SIGNAL(currentChanged(int)), this, SLOT(renderThumbnails()));
     connect(ui->ibiPlot, SIGNAL(ibiSelectedInsertMissingPeaks()), this, SLOT(insertMissingPeaks()));
     connect(ui->ibiPlot, SIGNAL(ibiSelected(bool)), ui->jumpToSelectionButton, SLOT(setEnabled(bool)));
     connect(ui->jumpToSelectionButton, SIGNAL(clicked()), this, SLOT(jumpToSelection()));
     connect(ui->ibiPlot, SIGNAL(ibiSelectedDoubleClick()), this, SLOT(jumpToSelection()));
     connect(ui->resetIbiViewButton, SIGNAL(clicked()), ui->ibiPlot, SLOT(resetView()));
 
+    // Artifact detection methods, in the order of ArtifactDetector::Method
+    for (int m = 0; m < ArtifactDetector::methodCount(); m++)
+    {
+        ui->artifactMethodComboBox->addItem(ArtifactDetector::methodName((ArtifactDetector::Method) m));
+    }
+
     // Initialize sample rate label
     ui->ecgPlot->setSampleRate(0);
+    fileSampleRate = 0;
     sampleRateLabel = new QLabel(this);
     ui->statusBar->addPermanentWidget(sampleRateLabel);
     updateSampleRateLabel();
@@ -128,6 +226,9 @@ void MainWindow::getFileName()
 
 void MainWindow::closeCurrentFile()
 {
+    stopSignalQuality();
+    stopReview();
+
     // Clear plots
     ui->ecgPlot->clear();
     ui->ibiPlot->clear();
@@ -135,11 +236,26 @@ void MainWindow::closeCurrentFile()
 
     // Disable buttons
     ui->detectPeaksButton->setEnabled(false);
+    ui->classifyBeatsButton->setEnabled(false);
+    ui->averageBeatsButton->setEnabled(false);
+    ui->saveEnsembleButton->setEnabled(false);
+    ui->ensemblePlot->clear();
+    ui->spectrumPlot->clear();
+    ui->trendPlot->clear();
+    ui->sampEnLabel->setText("-");
+    ui->dfaAlpha1Label->setText("-");
+    ui->dfaAlpha2Label->setText("-");
+    ui->nonlinearTimeLabel->setText("-");
+    ui->saveTrendButton->setEnabled(false);
     ui->menuCloseCurrentFile->setEnabled(false);
+    ui->menuInvertSignal->setEnabled(false);
     ui->menuSavePeakPositions->setEnabled(false);
+    ui->menuSaveBeatFeatures->setEnabled(false);
     ui->menuSaveInterbeatIntervals->setEnabled(false);
+    ui->menuSaveHeartRate->setEnabled(false);
 
     openFileName = "";
+    updateSampleRateLabel();
 }
 
 void MainWindow::saveInterbeatIntervals()
@@ -168,10 +284,13 @@ void MainWindow::saveInterbeatIntervals()
     // Paste text
     QTextStream out(&outFile);
 
-    if (dialog.includeSignalStartEnd())
+    // Signal start and end are only known if there is an ecg signal
+    bool includeSignalStartEnd = dialog.includeSignalStartEnd() && !ui->ecgPlot->getPeaks().isEmpty();
+
+    if (includeSignalStartEnd)
     {
         // Include signal start to first peak as interbeat interval
-        out << ui->ecgPlot->getPeaks().first()->point1->key() * 1000 << "\n";
+        out << ui->ecgPlot->getPeaks().first() * 1000 << "\n";
     }
 
     QVector<double> ibi_y = ui->ibiPlot->getIbi_y();
@@ -181,10 +300,10 @@ void MainWindow::saveInterbeatIntervals()
         out << ibi_y[i] << "\n";
     }
 
-    if (dialog.includeSignalStartEnd())
+    if (includeSignalStartEnd)
     {
         // Include last peak to signal and as interbeat interval
-        out << ui->ecgPlot->getEcg_x().last() * 1000 - ui->ecgPlot->getPeaks().last()->point1->key() * 1000 << "\n";
+        out << ui->ecgPlot->getDuration() * 1000 - ui->ecgPlot->getPeaks().last() * 1000 << "\n";
     }
 
     // Close
@@ -213,13 +332,12 @@ void MainWindow::savePeakPositions()
     // Paste text
     QTextStream out(&outFile);
 
-    QLinkedList<QCPItemStraightLine*> peaks = ui->ecgPlot->getPeaks();
-    QLinkedList<QCPItemStraightLine*>::iterator iter;
+    const PeakStore &peaks = ui->ecgPlot->getPeaks();
 
     // Write peaks to file
-    for(iter = peaks.begin(); iter != peaks.end(); iter++)
+    for (int i = 0; i < peaks.size(); i++)
     {
-        out << (*iter)->point1->key() << "\n";
+        out << peaks.at(i) << "\n";
     }
 
     // Close
@@ -229,8 +347,101 @@ void MainWindow::savePeakPositions()
     ui->statusBar->showMessage("Peak positions exported", 2000);
 }
 
+void MainWindow::saveBeatFeatures()
+{
+    // New filename prototype
+    QFileInfo fn(openFileName);
+    QString newFn = fn.canonicalPath() + QDir::separator() + fn.baseName() + "_features.txt";
+
+    QString outFileName = QFileDialog::getSaveFileName(this, "Save As", newFn);
+
+    if (outFileName == "") return;
+
+    QFile outFile(outFileName);
+    if (!outFile.open(QIODevice::WriteOnly | QIODevice::Text)) return;
+
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+
+    BeatFeatures features = ui->ecgPlot->measureBeats();
+    const PeakStore &peaks = ui->ecgPlot->getPeaks();
+
+    QTextStream out(&outFile);
+
+    // One row per peak, the first column matches the peaks file
+    out << "position\tectopic";
+
+    for (int f = 0; f < BeatFeatures::FeatureCount; f++)
+    {
+        out << "\t" << BeatFeatures::name((BeatFeatures::Feature) f);
+    }
+
+    out << "\n";
+
+    for (int i = 0; i < features.size(); i++)
+    {
+        out << features.positions()[i] << "\t" << (peaks.isEctopic(i) ? 1 : 0);
+
+        for (int f = 0; f < BeatFeatures::FeatureCount; f++)
+        {
+            out << "\t" << features.column((BeatFeatures::Feature) f)[i];
+        }
+
+        out << "\n";
+    }
+
+    outFile.flush();
+    outFile.close();
+
+    QApplication::restoreOverrideCursor();
+    ui->statusBar->showMessage("Beat features exported", 2000);
+}
+
+void MainWindow::saveHeartRate()
+{
+    // New filename prototype
+    QFileInfo fn(openFileName);
+    QString newFn = fn.canonicalPath() + QDir::separator() + fn.baseName() + "_hr.txt";
+
+    QString outFileName = QFileDialog::getSaveFileName(this, "Save As", newFn);
+
+    if (outFileName == "") return;
+
+    QFile outFile(outFileName);
+    if (!outFile.open(QIODevice::WriteOnly | QIODevice::Text)) return;
+
+    QTextStream out(&outFile);
+
+    // Only the samples between the first and the last interval
+    const QVector<double> &values = heartRate.values();
+
+    out << "time\thr\n";
+
+    for (int k = heartRate.firstSample(); k <= heartRate.lastSample(); k++)
+    {
+        out << k / heartRate.getRate() << "\t" << values[k] << "\n";
+    }
+
+    outFile.flush();
+    outFile.close();
+
+    ui->statusBar->showMessage("Heart rate exported (" + QString::number(heartRate.getRate()) + " Hz)", 2000);
+}
+
 void MainWindow::peakDetection()
 {
+    // Unusable segments are only known once all of them have been assessed
+    if (ui->skipUnusableCheckBox->isChecked() && qualityWatcher->isRunning())
+    {
+        ui->statusBar->showMessage("Assessing signal quality ...");
+        QApplication::setOverrideCursor(Qt::WaitCursor);
+
+        qualityWatcher->waitForFinished();
+        showSignalQuality(0, qualityWatcher->future().resultCount());
+
+        QApplication::restoreOverrideCursor();
+        ui->statusBar->clearMessage();
+    }
+
     ui->ecgPlot->peakdet(ui->localThresholdSpinBox->value(), ui->globalThresholdSpinBox->value(), ui->minRRIntervallSpinBox->value());
 
     // Plot interbeat intervals and histogram
@@ -241,272 +452,1140 @@ void MainWindow::peakDetection()
 
     // Enable buttons
     ui->menuSavePeakPositions->setEnabled(true);
+    ui->menuSaveBeatFeatures->setEnabled(true);
     ui->menuSaveInterbeatIntervals->setEnabled(true);
+    ui->menuSaveHeartRate->setEnabled(true);
     ui->updateIbiButton->setEnabled(true);
+    ui->classifyBeatsButton->setEnabled(true);
+    ui->averageBeatsButton->setEnabled(true);
     ui->resetIbiViewButton->setEnabled(true);
     ui->artifactDetectionPushButton->setEnabled(true);
     ui->insertMissingPeaksButton->setEnabled(true);
+    ui->correctAllArtifactsButton->setEnabled(true);
 }
 
-void MainWindow::setupIbiPlot()
+void MainWindow::classifyBeats()
 {
-    if (!ui->ecgPlot->getPeaks().isEmpty())
-    {
-        ui->ibiPlot->setup(ui->ecgPlot->getPeaks());
-    }
-}
+    if (ui->ecgPlot->getPeaks().isEmpty()) return;
 
-void MainWindow::jumpToSelection()
-{
-    double x = ui->ibiPlot->getSelectionTimePoint();
+    ui->statusBar->showMessage("Classifying beats ...");
+    QApplication::setOverrideCursor(Qt::WaitCursor);
 
-    // Add position of first peak to x
-    x += ui->ecgPlot->getPeaks().first()->point1->key();
+    QTime timer;
+    timer.start();
 
-    // Set view port to selected peak
-    ui->ecgPlot->xAxis->setRange(x, ui->ecgPlot->xAxis->range().size(), Qt::AlignCenter);
+    TemplateMatcher matcher;
+    int ectopic = ui->ecgPlot->matchTemplate(matcher);
 
-    // x-value for highlight rect
-    double key = x - ui->ibiPlot->getSelectionPosY() / 1000 / 2;
+    // Refined peaks change the interbeat intervals
+    setupIbiPlot();
 
-    // Add highlight line
-    ui->ecgPlot->showIbiHighlightRect(key, ui->ibiPlot->getSelectionPosY() / 1000);
+    QApplication::restoreOverrideCursor();
+    ui->statusBar->showMessage(QString("%1 of %2 beats ectopic (%3 s)")
+                               .arg(ectopic)
+                               .arg(ui->ecgPlot->getPeaks().size())
+                               .arg(timer.elapsed() / 1000.0, 0, 'f', 1), 4000);
 }
 
-void MainWindow::insertMissingPeaks()
+void MainWindow::colorPeaks(int index)
 {
-    double artifact_size = ui->ibiPlot->getSelectionPosY() / 1000;
-    double artifact_pos = ui->ibiPlot->getSelectionTimePoint() + ui->ecgPlot->getTimeBeforeFirstPeak() - artifact_size;
+    // First entry is "None"
+    ui->ecgPlot->setPeakColorFeature(index - 1);
+}
 
-    // Get size of the interbeat interval before selection as reference interval
-    double ref = ui->ibiPlot->getReferenceInterval();
+void MainWindow::averageBeats()
+{
+    const PeakStore &peaks = ui->ecgPlot->getPeaks();
 
-    // Calculate number of new intervals
-    int n = qRound(artifact_size / ref);
+    if (peaks.isEmpty()) return;
 
-    // Get size of new beats
-    double new_size = artifact_size / n;
+    QVector<double> beats;
+    beats.reserve(peaks.size());
 
-    // TODO: evtl. hier insertPeakAtTimePoints definieren
-    for (int i = 1; i < n; i++)
+    for (int i = 0; i < peaks.size(); i++)
     {
-        ui->ecgPlot->insertPeakAtTimePoint(artifact_pos + (double)i * new_size);
+        if (ui->cleanBeatsCheckBox->isChecked() && (peaks.isEctopic(i) || !ui->ecgPlot->isUsable(peaks.at(i)))) continue;
+
+        beats << peaks.at(i);
     }
 
-    ui->ecgPlot->replot();
+    ui->statusBar->showMessage("Averaging beats ...");
+    QApplication::setOverrideCursor(Qt::WaitCursor);
 
-    // TODO: don't reset viewport here
-    // Plot interbeat intervals and histogram
-    //ui->ibiPlot->setup(ui->ecgPlot->getPeaks());
-    ui->ibiPlot->setup(ui->ecgPlot->getPeaks(), false);
-}
+    EnsembleAverager averager;
+    averager.setWindow(ui->ensembleBeforeSpinBox->value() / 1000.0, ui->ensembleAfterSpinBox->value() / 1000.0);
 
-void MainWindow::aboutPeakMan()
-{
-    QMessageBox::about(this, "About PeakMan",
-                       "<p><b>PeakMan</b><br>Version 0.4.0</p>"
-                       "<p>Copyright (C) 2014-2016 Daniel Gromer</p>"
-                       "<p><a href='https://github.com/dgromer/PeakMan'>https://github.com/dgromer/PeakMan</a></p>"
-                       "<p>This program is licensed to you under the terms of version 3 of the GNU <a href='http://www.gnu.org/licenses/gpl-3.0.txt'>General Public License</a>.");
-}
+    // The filtered signal is shown, so that is what gets averaged
+    const ECGSignal &signal = ui->ecgPlot->getFilteredSignal().isEmpty() ? ui->ecgPlot->getSignal() : ui->ecgPlot->getFilteredSignal();
+    ensembleAverage = averager.apply(signal, ui->ecgPlot->getSampleRate(), beats);
 
-void MainWindow::execOpenFileDialog()
-{
-    OpenFileDialog dialog(this, openFileName, ui->ecgPlot->getSampleRate());
-    dialog.exec();
+    QApplication::restoreOverrideCursor();
 
-    if (dialog.result() == QDialog::Accepted)
+    if (ensembleAverage.beats == 0)
     {
-        //sampleRate = dialog.getSampleRate();
-        ui->ecgPlot->setSampleRate(dialog.getSampleRate());
-        updateSampleRateLabel();
-
-        if (dialog.getRadioButtonPushed() == "ecgsignal")
-        {
-            openEcgFile();
-        }
-        else if (dialog.getRadioButtonPushed() == "peaks")
-        {
-            openPeaksFile();
-        }
-        else if (dialog.getRadioButtonPushed() == "ibi")
-        {
-            openIbiFile();
-        }
+        ui->ensemblePlot->clear();
+        ui->saveEnsembleButton->setEnabled(false);
+        ui->statusBar->showMessage("No beats to average", 2000);
+        return;
     }
+
+    ui->ensemblePlot->plot(ensembleAverage);
+    ui->saveEnsembleButton->setEnabled(true);
+
+    ui->statusBar->showMessage(QString::number(ensembleAverage.beats) + " beats averaged", 2000);
 }
 
-void MainWindow::openEcgFile()
+void MainWindow::saveEnsembleAverage()
 {
-    // If there's already an open file, close it before opening the new one
-    if (!ui->ecgPlot->getEcg_y().isEmpty()) closeCurrentFile();
+    if (ensembleAverage.beats == 0) return;
 
-    ui->statusBar->showMessage("Opening file ...");
+    // New filename prototype
+    QFileInfo fn(openFileName);
+    QString newFn = fn.canonicalPath() + QDir::separator() + fn.baseName() + "_ensemble.txt";
+
+    QString outFileName = QFileDialog::getSaveFileName(this, "Save As", newFn);
 
-    QFile file(openFileName);
+    if (outFileName == "") return;
 
-    // Open file
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) return;
+    QFile outFile(outFileName);
+    if (!outFile.open(QIODevice::WriteOnly | QIODevice::Text)) return;
 
-    QTextStream in(&file);
+    QTextStream out(&outFile);
 
-    // Store ecg signal here
-    QVector<double> ecg_y;
+    // One row per sample of the window: time relative to the R peak (ms),
+    // mean and standard deviation
+    out << "time\tmean\tsd\n";
 
-    // Read file line by line
-    while (!in.atEnd())
+    for (int i = 0; i < ensembleAverage.time.size(); i++)
     {
-        ecg_y << in.readLine().toDouble();
+        out << ensembleAverage.time[i] * 1000 << "\t" << ensembleAverage.mean[i] << "\t" << ensembleAverage.sd[i] << "\n";
     }
 
-    file.close();
+    outFile.flush();
+    outFile.close();
+
+    ui->statusBar->showMessage("Ensemble average exported (" + QString::number(ensembleAverage.beats) + " beats)", 2000);
+}
 
-    // x-axis vector for ecg signal with time points in seconds
-    QVector<double> ecg_x;
+void MainWindow::computeSpectrum()
+{
+    QVector<double> intervals = ui->ibiPlot->getIbi_y();
 
-    // Create a vector with time for x-axis
-    for (int i = 0; i < ecg_y.size(); i++)
+    if (intervals.size() < 3)
     {
-        ecg_x << (double) i / ui->ecgPlot->getSampleRate();
+        ui->statusBar->showMessage("Not enough interbeat intervals for a spectrum", 2000);
+        return;
     }
 
-    // Plot ecg signal
-    ui->ecgPlot->plot(ecg_x, ecg_y);
+    ui->statusBar->showMessage("Computing spectrum ...");
+    QApplication::setOverrideCursor(Qt::WaitCursor);
 
-    // Adjust size of horizontal scrollbar
-    ui->horizontalScrollBar->setRange(0, ecg_x.last() * 100);
+    QTime timer;
+    timer.start();
 
-    // Enable menu entries
-    ui->detectPeaksButton->setEnabled(true);
-    ui->menuCloseCurrentFile->setEnabled(true);
+    HRVSpectrum spectrum;
+    HRVSpectrum::Result lombScargle = spectrum.compute(intervals);
+    int lombScargleTime = timer.restart();
+
+    spectrum.setMethod(HRVSpectrum::ResampledFFT);
+    HRVSpectrum::Result fft = spectrum.compute(intervals);
+    int fftTime = timer.elapsed();
+
+    ui->spectrumPlot->plot(lombScargle, fft);
 
-    ui->statusBar->showMessage("File opened", 2000);
+    ui->lombScargleVlfLabel->setText(QString::number(lombScargle.vlf, 'f', 0) + " ms^2");
+    ui->lombScargleLfLabel->setText(QString::number(lombScargle.lf, 'f', 0) + " ms^2");
+    ui->lombScargleHfLabel->setText(QString::number(lombScargle.hf, 'f', 0) + " ms^2");
+    ui->lombScargleLfHfLabel->setText(lombScargle.hf > 0 ? QString::number(lombScargle.lf / lombScargle.hf, 'f', 2) : "-");
+    ui->fftVlfLabel->setText(QString::number(fft.vlf, 'f', 0) + " ms^2");
+    ui->fftLfLabel->setText(QString::number(fft.lf, 'f', 0) + " ms^2");
+    ui->fftHfLabel->setText(QString::number(fft.hf, 'f', 0) + " ms^2");
+    ui->fftLfHfLabel->setText(fft.hf > 0 ? QString::number(fft.lf / fft.hf, 'f', 2) : "-");
+
+    QApplication::restoreOverrideCursor();
+    ui->statusBar->showMessage(QString("Spectrum of %1 intervals (Lomb-Scargle %2 s, FFT %3 s)")
+                               .arg(intervals.size())
+                               .arg(lombScargleTime / 1000.0, 0, 'f', 2)
+                               .arg(fftTime / 1000.0, 0, 'f', 2), 4000);
 }
 
-void MainWindow::openPeaksFile()
+void MainWindow::computeNonlinear()
 {
-    if (ui->ecgPlot->getEcg_y().isEmpty())
-    {
-        // TODO: error message, load ecg data first
-    }
+    QVector<double> intervals = ui->ibiPlot->getIbi_y();
 
-    // If there are already peaks plotted, delete these
-    if (!ui->ecgPlot->getPeaks().isEmpty())
+    if (intervals.size() < 8)
     {
-        ui->ecgPlot->clearPeaks();
+        ui->statusBar->showMessage("Not enough interbeat intervals for nonlinear analysis", 2000);
+        return;
     }
 
-    ui->statusBar->showMessage("Opening file ...");
+    ui->statusBar->showMessage("Computing sample entropy and DFA ...");
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+
+    QTime timer;
+    timer.start();
 
-    QFile file(openFileName);
+    double sampleEntropy = NonlinearHRV::sampleEntropy(intervals);
+    int sampleEntropyTime = timer.restart();
 
-    // Open file
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) return;
+    NonlinearHRV::DFA dfa = NonlinearHRV::detrendedFluctuation(intervals);
+    int dfaTime = timer.elapsed();
 
-    QTextStream in(&file);
+    ui->sampEnLabel->setText(qIsNaN(sampleEntropy) ? "-" : QString::number(sampleEntropy, 'f', 3));
+    ui->dfaAlpha1Label->setText(qIsNaN(dfa.alpha1) ? "-" : QString::number(dfa.alpha1, 'f', 3));
+    ui->dfaAlpha2Label->setText(qIsNaN(dfa.alpha2) ? "-" : QString::number(dfa.alpha2, 'f', 3));
+    ui->nonlinearTimeLabel->setText(QString("%1 / %2 s").arg(sampleEntropyTime / 1000.0, 0, 'f', 2).arg(dfaTime / 1000.0, 0, 'f', 2));
+
+    QApplication::restoreOverrideCursor();
+    ui->statusBar->showMessage(QString("Nonlinear analysis of %1 intervals (SampEn %2 s, DFA %3 s)")
+                               .arg(intervals.size())
+                               .arg(sampleEntropyTime / 1000.0, 0, 'f', 2)
+                               .arg(dfaTime / 1000.0, 0, 'f', 2), 4000);
+}
 
-    // Store peak positions in vector
-    QVector<double> peaks_x;
+void MainWindow::computeTrend()
+{
+    QVector<double> peaks = beatTimes();
 
-    // Read file line by line
-    while (!in.atEnd())
+    if (peaks.size() < 3)
     {
-        peaks_x << in.readLine().toDouble();
+        ui->statusBar->showMessage("Not enough interbeat intervals for a trend", 2000);
+        return;
     }
 
-    file.close();
+    QTime timer;
+    timer.start();
 
-    ui->ecgPlot->insertPeaksFromVector(peaks_x);
+    SlidingHRV sliding;
+    sliding.setWindow(ui->trendWindowSpinBox->value() * 60);
+    sliding.setStep(ui->trendStepSpinBox->value());
+    trend = sliding.compute(peaks);
 
-    // Insert peaks in ecgplot
-    // Create a function in ecgplot.cpp which takes the peaks_x vector
-    // from here and fills the peaks with peaks.append(insertNewPeak(mxpos))
+    ui->trendPlot->plot(trend, sliding.getWindow());
+    ui->trendPlot->setTimeRange(ui->ecgPlot->xAxis->range());
+    ui->saveTrendButton->setEnabled(true);
 
-    // Plot interbeat intervals and histogram
-    setupIbiPlot();
+    ui->statusBar->showMessage(QString("%1 windows in %2 s")
+                               .arg(trend.start.size())
+                               .arg(timer.elapsed() / 1000.0, 0, 'f', 2), 4000);
+}
 
-    // Reset IBI plot ranges
-    ui->ibiPlot->resetView();
+void MainWindow::saveTrend()
+{
+    // New filename prototype
+    QFileInfo fn(openFileName);
+    QString newFn = fn.canonicalPath() + QDir::separator() + fn.baseName() + "_trend.txt";
 
-    // Enable buttons
-    ui->menuSavePeakPositions->setEnabled(true);
-    ui->menuSaveInterbeatIntervals->setEnabled(true);
-    ui->updateIbiButton->setEnabled(true);
-    ui->resetIbiViewButton->setEnabled(true);
-    ui->artifactDetectionPushButton->setEnabled(true);
-    ui->insertMissingPeaksButton->setEnabled(true);
+    QString outFileName = QFileDialog::getSaveFileName(this, "Save As", newFn);
+
+    if (outFileName == "") return;
+
+    QFile outFile(outFileName);
+    if (!outFile.open(QIODevice::WriteOnly | QIODevice::Text)) return;
+
+    QTextStream out(&outFile);
+
+    // One row per window, windows with too few intervals are written as nan.
+    // The window is the one the trend was computed with.
+    out << "start\tend\tintervals\tmean_hr\tsdnn\trmssd\n";
+
+    for (int i = 0; i < trend.start.size(); i++)
+    {
+        out << trend.start[i] << "\t" << trend.start[i] + trend.window << "\t" << trend.intervals[i] << "\t"
+            << trend.meanHR[i] << "\t" << trend.sdnn[i] << "\t" << trend.rmssd[i] << "\n";
+    }
+
+    outFile.flush();
+    outFile.close();
 
-    ui->statusBar->showMessage("File opened", 2000);
+    ui->statusBar->showMessage("HRV trend exported", 2000);
 }
 
-void MainWindow::openIbiFile()
+void MainWindow::trendRangeChanged(QCPRange range)
 {
+    // Interval files have no ecg signal to follow, and ranges coming from
+    // the ecg plot are already there
+    if (ui->ecgPlot->getSignal().isEmpty()) return;
+    if (range.lower == ui->ecgPlot->xAxis->range().lower && range.upper == ui->ecgPlot->xAxis->range().upper) return;
 
+    ui->ecgPlot->xAxis->setRange(range);
+    ui->ecgPlot->replot();
 }
 
-void MainWindow::dragEnterEvent(QDragEnterEvent *event)
+QVector<double> MainWindow::beatTimes() const
 {
-    event->accept();
+    if (!ui->ecgPlot->getPeaks().isEmpty())
+    {
+        return ui->ecgPlot->getPeaks().positions();
+    }
+
+    QVector<double> intervals = ui->ibiPlot->getIbi_y();
+
+    if (intervals.isEmpty()) return QVector<double>();
+
+    QVector<double> peaks(intervals.size() + 1, 0);
+
+    for (int i = 0; i < intervals.size(); i++)
+    {
+        peaks[i + 1] = peaks[i] + intervals[i] / 1000;
+    }
+
+    return peaks;
 }
 
-void MainWindow::dropEvent(QDropEvent *event)
+void MainWindow::updateFilter()
 {
-    // Read paths from drop event
-    QList<QUrl> urls = event->mimeData()->urls();
+    if (ui->ecgPlot->getSignal().isEmpty()) return;
 
-    // Error if more than one file is dropped
-    if (urls.length() > 1)
+    if (!ui->removeBaselineCheckBox->isChecked() && !ui->filterGroupBox->isChecked())
     {
-        QMessageBox::information(this, "Error", "Only one file allowed");
+        // Back to the unfiltered signal
+        ui->ecgPlot->setBaseline(ECGSignal());
+        ui->ecgPlot->setFilteredSignal(ECGSignal());
         return;
     }
 
-    // Only open one file, so use first path only
-    QFileInfo in(urls.first().toLocalFile());
+    ui->statusBar->showMessage("Filtering ...");
+    QApplication::setOverrideCursor(Qt::WaitCursor);
 
-    if (in.suffix() != "txt")
+    QTime timer;
+    timer.start();
+
+    ECGSignal processed = ui->ecgPlot->getSignal();
+    ECGSignal baseline;
+
+    if (ui->removeBaselineCheckBox->isChecked())
     {
-        QMessageBox::information(this, "Error", "Only text files allowed");
-        return;
+        BaselineFilter baselineFilter;
+        processed = baselineFilter.apply(processed, ui->ecgPlot->getSampleRate(), &baseline);
     }
 
-    openFileName = in.absoluteFilePath();
+    if (ui->filterGroupBox->isChecked())
+    {
+        ECGFilter filter;
+        filter.setHighPass(ui->highPassSpinBox->value());
+        filter.setLowPass(ui->lowPassSpinBox->value());
 
-    execOpenFileDialog();
+        // Notch entries: none, 50 Hz, 60 Hz
+        if (ui->notchComboBox->currentIndex() == 1) filter.setNotch(50);
+        if (ui->notchComboBox->currentIndex() == 2) filter.setNotch(60);
+
+        processed = filter.apply(processed, ui->ecgPlot->getSampleRate());
+    }
+
+    ui->ecgPlot->setBaseline(baseline);
+    ui->ecgPlot->setFilteredSignal(processed);
+
+    QApplication::restoreOverrideCursor();
+    ui->statusBar->showMessage("Signal filtered in " + QString::number(timer.elapsed() / 1000.0, 'f', 1) + " s", 2000);
 }
 
-void MainWindow::updateSampleRateLabel()
+void MainWindow::startSignalQuality(const ECGSignal &signal)
 {
-    sampleRateLabel->setText("   Sample Rate: " + QString::number(ui->ecgPlot->getSampleRate()) + " Hz ");
+    stopSignalQuality();
+
+    SignalQuality quality;
+    ui->ecgPlot->setSegmentDuration(quality.getSegmentLength());
+
+    qualityWatcher->setFuture(quality.start(signal, ui->ecgPlot->getSampleRate()));
 }
 
-void MainWindow::closeEvent(QCloseEvent *event)
+void MainWindow::stopSignalQuality()
 {
-    saveSettings();
-    event->accept();
+    // Segments already running can't be cancelled, wait for them
+    qualityWatcher->cancel();
+    qualityWatcher->waitForFinished();
 }
 
-void MainWindow::saveSettings()
+void MainWindow::showSignalQuality(int begin, int end)
 {
-    QSettings settings(QDir::currentPath() + "/peakman.ini", QSettings::IniFormat);
+    bool changed = false;
 
-    settings.beginGroup("MainWindow");
+    for (int i = begin; i < end; i++)
+    {
+        bool usable = qualityWatcher->resultAt(i).usable;
 
-    // Save position and size of window
-    settings.setValue("size", size());
-    settings.setValue("pos", pos());
+        ui->ecgPlot->setSegmentUsable(i, usable);
 
-    // Save sample rate for ecg data
-    settings.setValue("samplerate", ui->ecgPlot->getSampleRate());
+        if (!usable) changed = true;
+    }
 
-    // Save settings for peak detection algorithm
-    settings.setValue("delta", ui->localThresholdSpinBox->value());
+    // Usable segments aren't shaded, nothing to redraw for them
+    if (changed) ui->ecgPlot->replot();
+}
+
+void MainWindow::signalQualityFinished()
+{
+    if (qualityWatcher->isCanceled()) return;
+
+    QList<SignalQuality::Segment> segments = qualityWatcher->future().results();
+    int unusable = 0;
+
+    for (int i = 0; i < segments.size(); i++)
+    {
+        if (!segments[i].usable) unusable++;
+    }
+
+    if (unusable > 0)
+    {
+        ui->statusBar->showMessage("Signal quality: " + QString::number(unusable) + " of " + QString::number(segments.size()) + " segments unusable", 4000);
+    }
+}
+
+void MainWindow::setupIbiPlot()
+{
+    if (!ui->ecgPlot->getPeaks().isEmpty())
+    {
+        ui->ibiPlot->setup(ui->ecgPlot->getPeaks().positions());
+    }
+
+    showRespiration();
+
+    // Peak colors follow the edited peaks
+    ui->ecgPlot->updateBeatFeatures();
+}
+
+void MainWindow::resetHistogram()
+{
+    // Shown with the next update of the interbeat intervals
+    histogram.reset(ui->ecgPlot->getPeaks().positions());
+}
+
+void MainWindow::updateHistogram(const PeakEdit &edit)
+{
+    histogram.update(ui->ecgPlot->getPeaks().positions(), edit);
+}
+
+void MainWindow::resetRespiration()
+{
+    if (ui->showRespirationCheckBox->isChecked())
+    {
+        edr.reset(ui->ecgPlot->activeSignal(), ui->ecgPlot->getSampleRate(), ui->ecgPlot->getPeaks().positions());
+    }
+    else
+    {
+        edr.clear();
+    }
+
+    showRespiration();
+}
+
+void MainWindow::updateRespiration(const PeakEdit &edit)
+{
+    if (!ui->showRespirationCheckBox->isChecked()) return;
+
+    // Shown with the next update of the interbeat intervals
+    edr.update(ui->ecgPlot->activeSignal(), ui->ecgPlot->getSampleRate(), ui->ecgPlot->getPeaks().positions(), edit);
+}
+
+void MainWindow::resetHeartRate()
+{
+    heartRate.reset(ui->ecgPlot->getPeaks().positions(), ui->ecgPlot->getDuration());
+
+    ui->ecgPlot->setHeartRate(heartRate.values(), heartRate.getRate());
+}
+
+void MainWindow::updateHeartRate(const PeakEdit &edit)
+{
+    heartRate.update(ui->ecgPlot->getPeaks().positions(), edit);
+
+    // Shown with the next replot after the edit
+    ui->ecgPlot->updateHeartRate(heartRate.values(), heartRate.getRate(), heartRate.changedFrom(), heartRate.changedTo());
+}
+
+void MainWindow::resetHrvMetrics()
+{
+    hrvMetrics.reset(ui->ecgPlot->getPeaks().positions());
+
+    showHrvMetrics();
+}
+
+void MainWindow::updateHrvMetrics(const PeakEdit &edit)
+{
+    hrvMetrics.update(ui->ecgPlot->getPeaks().positions(), edit);
+
+    showHrvMetrics();
+}
+
+void MainWindow::showHrvMetrics()
+{
+    if (hrvMetrics.isEmpty())
+    {
+        ui->sdnnLabel->setText("-");
+        ui->rmssdLabel->setText("-");
+        ui->pnn50Label->setText("-");
+        ui->meanHrLabel->setText("-");
+        ui->meanRrLabel->setText("-");
+        ui->intervalsLabel->setText("-");
+        return;
+    }
+
+    HRVMetrics::Metrics m = hrvMetrics.metrics();
+
+    ui->sdnnLabel->setText(QString::number(m.sdnn, 'f', 1) + " ms");
+    ui->rmssdLabel->setText(QString::number(m.rmssd, 'f', 1) + " ms");
+    ui->pnn50Label->setText(QString::number(m.pnn50, 'f', 1) + " %");
+    ui->meanHrLabel->setText(QString::number(m.meanHR, 'f', 1) + " bpm");
+    ui->meanRrLabel->setText(QString::number(m.meanRR, 'f', 1) + " ms");
+    ui->intervalsLabel->setText(QString::number(m.intervals));
+}
+
+void MainWindow::showArtifactSummary(QString summary)
+{
+    ui->statusBar->showMessage(summary, 4000);
+}
+
+void MainWindow::resetPoincare()
+{
+    poincare.reset(ui->ecgPlot->getPeaks().positions());
+
+    showPoincare(true);
+}
+
+void MainWindow::updatePoincare(const PeakEdit &edit)
+{
+    poincare.update(ui->ecgPlot->getPeaks().positions(), edit);
+
+    showPoincare(false);
+}
+
+void MainWindow::showPoincare(bool rescale)
+{
+    if (poincare.isEmpty())
+    {
+        ui->poincarePlot->clear();
+        ui->sd1Label->setText("-");
+        ui->sd2Label->setText("-");
+        ui->sd1Sd2Label->setText("-");
+        return;
+    }
+
+    ui->poincarePlot->plot(poincare, rescale);
+
+    ui->sd1Label->setText(QString::number(poincare.sd1(), 'f', 1) + " ms");
+    ui->sd2Label->setText(QString::number(poincare.sd2(), 'f', 1) + " ms");
+    ui->sd1Sd2Label->setText(poincare.sd2() > 0 ? QString::number(poincare.sd1() / poincare.sd2(), 'f', 2) : "-");
+}
+
+void MainWindow::showRespiration()
+{
+    ui->ibiPlot->setRespiration(edr.values(), edr.getRate(), ui->ecgPlot->getPeaks().positions());
+}
+
+void MainWindow::jumpToSelection()
+{
+    // Nothing to jump to without an ecg signal
+    if (ui->ecgPlot->getPeaks().isEmpty()) return;
+
+    double x = ui->ibiPlot->getSelectionTimePoint();
+
+    // Add position of first peak to x
+    x += ui->ecgPlot->getPeaks().first();
+
+    // Set view port to selected peak
+    ui->ecgPlot->xAxis->setRange(x, ui->ecgPlot->xAxis->range().size(), Qt::AlignCenter);
+
+    // x-value for highlight rect
+    double key = x - ui->ibiPlot->getSelectionPosY() / 1000 / 2;
+
+    // Add highlight line
+    ui->ecgPlot->showIbiHighlightRect(key, ui->ibiPlot->getSelectionPosY() / 1000);
+}
+
+void MainWindow::insertMissingPeaks()
+{
+    if (ui->ecgPlot->getPeaks().isEmpty()) return;
+
+    double artifact_size = ui->ibiPlot->getSelectionPosY() / 1000;
+    double artifact_pos = ui->ibiPlot->getSelectionTimePoint() + ui->ecgPlot->getTimeBeforeFirstPeak() - artifact_size;
+
+    // Get size of the interbeat interval before selection as reference interval
+    double ref = ui->ibiPlot->getReferenceInterval();
+
+    // Calculate number of new intervals
+    int n = qRound(artifact_size / ref);
+
+    // Get size of new beats
+    double new_size = artifact_size / n;
+
+    // TODO: evtl. hier insertPeakAtTimePoints definieren
+    for (int i = 1; i < n; i++)
+    {
+        ui->ecgPlot->insertPeakAtTimePoint(artifact_pos + (double)i * new_size);
+    }
+
+    ui->ecgPlot->replot();
+
+    // TODO: don't reset viewport here
+    // Plot interbeat intervals and histogram
+    //ui->ibiPlot->setup(ui->ecgPlot->getPeaks());
+    ui->ibiPlot->setup(ui->ecgPlot->getPeaks().positions(), false);
+    showRespiration();
+    ui->ecgPlot->updateBeatFeatures();
+}
+
+void MainWindow::correctAllArtifacts()
+{
+    if (ui->ecgPlot->getPeaks().isEmpty()) return;
+
+    QVector<int> artifacts = ui->ibiPlot->getArtifacts();
+
+    if (artifacts.isEmpty())
+    {
+        ui->statusBar->showMessage("No artifacts to correct, detect artifacts first", 2000);
+        return;
+    }
+
+    applyCorrection(artifacts);
+}
+
+void MainWindow::applyCorrection(const QVector<int> &artifacts)
+{
+    const PeakStore &peaks = ui->ecgPlot->getPeaks();
+    BeatCorrector::Result result = BeatCorrector::correct(peaks.positions(), peaks.flagValues(), artifacts);
+
+    // All corrections as one edit of the peaks, the interbeat intervals and
+    // histogram are set up once afterwards. The flags of the kept peaks stay,
+    // e.g. ectopic beats from the classification.
+    ui->ecgPlot->replacePeaks(result.peaks, result.flags);
+
+    ui->ibiPlot->setup(ui->ecgPlot->getPeaks().positions(), false);
+    ui->ibiPlot->artifactDetection();
+    showRespiration();
+    ui->ecgPlot->updateBeatFeatures();
+
+    ui->statusBar->showMessage(QString("Corrected artifacts: %1 beats inserted, %2 deleted, %3 merged, %4 intervals left unchanged")
+                               .arg(result.inserted).arg(result.deleted).arg(result.merged).arg(result.skipped), 4000);
+}
+
+void MainWindow::startReview()
+{
+    QVector<int> artifacts = ui->ibiPlot->getArtifacts();
+
+    if (ui->ecgPlot->getPeaks().isEmpty() || artifacts.isEmpty())
+    {
+        ui->statusBar->showMessage("No artifacts to review, detect artifacts first", 2000);
+        return;
+    }
+
+    stopReview();
+
+    reviewPeaks = ui->ecgPlot->getPeaks().positions();
+
+    QVector<double> sizes(artifacts.size());
+
+    for (int i = 0; i < artifacts.size(); i++)
+    {
+        sizes[i] = (reviewPeaks[artifacts[i] + 1] - reviewPeaks[artifacts[i]]) * 1000;
+    }
+
+    ui->artifactReview->setCandidates(artifacts, sizes);
+    ui->artifactReview->setFocus();
+
+    renderThumbnails();
+
+    ui->statusBar->showMessage(QString("Reviewing %1 artifacts").arg(artifacts.size()), 2000);
+}
+
+void MainWindow::stopReview()
+{
+    // Thumbnails already being rendered can't be cancelled, wait for them
+    thumbnailWatcher->cancel();
+    thumbnailWatcher->waitForFinished();
+
+    ui->artifactReview->clear();
+    ui->correctAcceptedButton->setEnabled(false);
+    reviewPeaks.clear();
+    thumbnailBatch.clear();
+}
+
+void MainWindow::renderThumbnails()
+{
+    // The next batch starts once the running one finished
+    if (thumbnailWatcher->isRunning()) return;
+
+    thumbnailBatch = ui->artifactReview->missingThumbnails();
+
+    if (thumbnailBatch.isEmpty()) return;
+
+    QVector<int> artifacts(thumbnailBatch.size());
+
+    for (int i = 0; i < thumbnailBatch.size(); i++)
+    {
+        artifacts[i] = ui->artifactReview->interval(thumbnailBatch[i]);
+    }
+
+    ArtifactThumbnails thumbnails;
+    thumbnailWatcher->setFuture(thumbnails.start(ui->ecgPlot->activeSignal(), ui->ecgPlot->getSampleRate(), reviewPeaks, artifacts));
+}
+
+void MainWindow::showThumbnails(int begin, int end)
+{
+    for (int i = begin; i < end; i++)
+    {
+        ui->artifactReview->setThumbnail(thumbnailBatch[i], thumbnailWatcher->resultAt(i));
+    }
+}
+
+void MainWindow::reviewDecisionsChanged()
+{
+    ui->correctAcceptedButton->setEnabled(ui->artifactReview->decidedCount(ArtifactReview::Accepted) > 0);
+}
+
+void MainWindow::correctAccepted()
+{
+    // Interval indices of the review are only valid for the peaks they were found in
+    if (ui->ecgPlot->getPeaks().positions() != reviewPeaks)
+    {
+        ui->statusBar->showMessage("Peaks changed since the review started, review the artifacts again", 4000);
+        return;
+    }
+
+    QVector<int> accepted = ui->artifactReview->accepted();
+
+    stopReview();
+    applyCorrection(accepted);
+}
+
+void MainWindow::aboutPeakMan()
+{
+    QMessageBox::about(this, "About PeakMan",
+                       "<p><b>PeakMan</b><br>Version 0.4.0</p>"
+                       "<p>Copyright (C) 2014-2016 Daniel Gromer</p>"
+                       "<p><a href='https://github.com/dgromer/PeakMan'>https://github.com/dgromer/PeakMan</a></p>"
+                       "<p>This program is licensed to you under the terms of version 3 of the GNU <a href='http://www.gnu.org/licenses/gpl-3.0.txt'>General Public License</a>.");
+}
+
+void MainWindow::execOpenFileDialog()
+{
+    OpenFileDialog dialog(this, openFileName, fileSampleRate);
+    dialog.exec();
+
+    if (dialog.result() == QDialog::Accepted)
+    {
+        if (dialog.getRadioButtonPushed() == "ecgsignal")
+        {
+            // Peaks and intervals are in seconds, only the ecg signal has a
+            // sample rate (which may differ from the plot's after resampling)
+            fileSampleRate = dialog.getSampleRate();
+            openEcgFile();
+        }
+        else if (dialog.getRadioButtonPushed() == "peaks")
+        {
+            openPeaksFile();
+        }
+        else if (dialog.getRadioButtonPushed() == "ibi")
+        {
+            openIbiFile();
+        }
+    }
+}
+
+void MainWindow::openEcgFile()
+{
+    // If there's already an open file, close it before opening the new one
+    if (!ui->ecgPlot->getSignal().isEmpty()) closeCurrentFile();
+
+    ui->statusBar->showMessage("Opening file ...");
+
+    showEcgSignal(resampleSignal(DataFile::readSignal(openFileName)));
+}
+
+void MainWindow::openPeaksFile()
+{
+    if (ui->ecgPlot->getSignal().isEmpty())
+    {
+        QMessageBox::information(this, "Error", "Open an ecg signal before opening peaks");
+        return;
+    }
+
+    ui->statusBar->showMessage("Opening file ...");
+
+    showPeaks(DataFile::readValues(openFileName));
+}
+
+void MainWindow::openIbiFile()
+{
+    // Interbeat interval files are shown without an ecg signal, so close
+    // whatever is open
+    closeCurrentFile();
+
+    ui->statusBar->showMessage("Opening file ...");
+
+    QVector<double> values = DataFile::readValues(openFileName);
+
+    // Store interbeat intervals (ms) in vector, skip anything that is not an
+    // interval
+    QVector<double> ibi_y;
+    ibi_y.reserve(values.size());
+
+    for (int i = 0; i < values.size(); i++)
+    {
+        if (values[i] > 0) ibi_y << values[i];
+    }
+
+    if (ibi_y.isEmpty())
+    {
+        ui->statusBar->showMessage("No interbeat intervals found", 2000);
+        return;
+    }
+
+    // Plot interbeat intervals and histogram
+    histogram.resetFromIntervals(ibi_y);
+    ui->ibiPlot->setupFromIntervals(ibi_y);
+    ui->ibiPlot->resetView();
+    ui->ibiPlot->artifactDetection();
+
+    // Beats at the cumulated intervals for the HRV metrics and the Poincaré plot
+    QVector<double> beats(ibi_y.size() + 1, 0);
+
+    for (int i = 0; i < ibi_y.size(); i++)
+    {
+        beats[i + 1] = beats[i] + ibi_y[i] / 1000;
+    }
+
+    hrvMetrics.reset(beats);
+    showHrvMetrics();
+    poincare.reset(beats);
+    showPoincare(true);
+
+    // Enable buttons, peak related actions need an ecg signal
+    ui->menuCloseCurrentFile->setEnabled(true);
+    ui->menuSaveInterbeatIntervals->setEnabled(true);
+    ui->resetIbiViewButton->setEnabled(true);
+    ui->artifactDetectionPushButton->setEnabled(true);
+    ui->updateIbiButton->setEnabled(false);
+    ui->insertMissingPeaksButton->setEnabled(false);
+    ui->correctAllArtifactsButton->setEnabled(false);
+
+    ui->statusBar->showMessage("File opened (" + QString::number(ibi_y.size()) + " interbeat intervals)", 2000);
+}
+
+void MainWindow::openNextFile()
+{
+    if (sessionQueue->isEmpty()) return;
+
+    ui->statusBar->showMessage("Opening file ...");
+
+    // Usually loaded already, otherwise this waits for it
+    Session session = sessionQueue->takeNext();
+
+    closeCurrentFile();
+
+    // Resampled while loading, if requested
+    openFileName = session.ecgFileName;
+    fileSampleRate = session.sampleRate;
+    ui->ecgPlot->setSampleRate(session.targetSampleRate > 0 ? session.targetSampleRate : session.sampleRate);
+    updateSampleRateLabel();
+
+    showEcgSignal(session.signal);
+
+    if (!session.peaksFileName.isEmpty() && !session.signal.isEmpty())
+    {
+        showPeaks(session.peaks);
+    }
+
+    ui->menuOpenNextFile->setEnabled(!sessionQueue->isEmpty());
+}
+
+ECGSignal MainWindow::resampleSignal(const ECGSignal &signal)
+{
+    int target = targetSampleRate() > 0 ? targetSampleRate() : fileSampleRate;
+
+    ui->ecgPlot->setSampleRate(target);
+    updateSampleRateLabel();
+
+    if (signal.isEmpty() || target == fileSampleRate) return signal;
+
+    ui->statusBar->showMessage("Resampling ...");
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+
+    Resampler resampler(fileSampleRate, target);
+    ECGSignal resampled = resampler.apply(signal);
+
+    QApplication::restoreOverrideCursor();
+
+    return resampled;
+}
+
+int MainWindow::targetSampleRate() const
+{
+    return ui->resampleGroupBox->isChecked() ? ui->resampleSpinBox->value() : 0;
+}
+
+void MainWindow::showEcgSignal(const ECGSignal &loaded)
+{
+    if (loaded.isEmpty())
+    {
+        ui->statusBar->showMessage("File could not be read or is empty", 2000);
+        return;
+    }
+
+    // Flip signals recorded with inverted leads, peak detection looks for
+    // maxima. The copy shares the samples, inverting only changes the gain.
+    ECGSignal signal = loaded;
+    bool inverted = ui->menuDetectPolarity->isChecked() && Polarity::isInverted(signal, ui->ecgPlot->getSampleRate());
+
+    if (inverted) signal.invert();
+
+    // Plot ecg signal
+    ui->ecgPlot->plot(signal);
+
+    startSignalQuality(signal);
+
+    // Adjust size of horizontal scrollbar
+    ui->horizontalScrollBar->setRange(0, ui->ecgPlot->getDuration() * 100);
+
+    // Enable menu entries
+    ui->detectPeaksButton->setEnabled(true);
+    ui->menuCloseCurrentFile->setEnabled(true);
+    ui->menuInvertSignal->setEnabled(true);
+
+    ui->statusBar->showMessage(QString("File opened (%1, %2 MB%3)")
+                               .arg(signal.encoding() == ECGSignal::Int16 ? "int16" : "float32")
+                               .arg(signal.bytes() / 1048576.0, 0, 'f', 1)
+                               .arg(signal.isMapped() ? ", swap file" : ""), 2000);
+
+    // Filter stage, if enabled
+    updateFilter();
+
+    if (inverted)
+    {
+        ui->statusBar->showMessage("Inverted signal detected, polarity flipped (Signal > Invert Signal to undo)", 6000);
+    }
+}
+
+void MainWindow::invertSignal()
+{
+    ui->ecgPlot->invertSignal();
+
+    ui->statusBar->showMessage("Signal inverted, detect peaks again to update them", 4000);
+}
+
+void MainWindow::showPeaks(QVector<double> peaks_x)
+{
+    // If there are already peaks plotted, delete these
+    if (!ui->ecgPlot->getPeaks().isEmpty())
+    {
+        ui->ecgPlot->clearPeaks();
+    }
+
+    // Insert peaks in ecgplot, peaks outside of the ecg signal are dropped
+    int rejected = ui->ecgPlot->insertPeaksFromVector(peaks_x);
+
+    if (ui->ecgPlot->getPeaks().isEmpty())
+    {
+        ui->statusBar->showMessage("No peaks within the ecg signal", 2000);
+        return;
+    }
+
+    // Plot interbeat intervals and histogram
+    setupIbiPlot();
+
+    // Reset IBI plot ranges
+    ui->ibiPlot->resetView();
+
+    // Enable buttons
+    ui->menuSavePeakPositions->setEnabled(true);
+    ui->menuSaveBeatFeatures->setEnabled(true);
+    ui->menuSaveInterbeatIntervals->setEnabled(true);
+    ui->menuSaveHeartRate->setEnabled(true);
+    ui->updateIbiButton->setEnabled(true);
+    ui->classifyBeatsButton->setEnabled(true);
+    ui->averageBeatsButton->setEnabled(true);
+    ui->resetIbiViewButton->setEnabled(true);
+    ui->artifactDetectionPushButton->setEnabled(true);
+    ui->insertMissingPeaksButton->setEnabled(true);
+    ui->correctAllArtifactsButton->setEnabled(true);
+
+    if (rejected > 0)
+    {
+        ui->statusBar->showMessage("File opened (" + QString::number(rejected) + " peaks outside of the ecg signal ignored)", 4000);
+    }
+    else
+    {
+        ui->statusBar->showMessage("File opened", 2000);
+    }
+}
+
+void MainWindow::dragEnterEvent(QDragEnterEvent *event)
+{
+    event->accept();
+}
+
+void MainWindow::dropEvent(QDropEvent *event)
+{
+    // Read paths from drop event
+    QList<QUrl> urls = event->mimeData()->urls();
+
+    if (urls.isEmpty()) return;
+
+    if (urls.length() > 1)
+    {
+        openFileBatch(urls);
+        return;
+    }
+
+    // Only open one file, so use first path only
+    QFileInfo in(urls.first().toLocalFile());
+
+    if (in.suffix() != "txt")
+    {
+        QMessageBox::information(this, "Error", "Only text files allowed");
+        return;
+    }
+
+    openFileName = in.absoluteFilePath();
+
+    execOpenFileDialog();
+}
+
+void MainWindow::openFileBatch(QList<QUrl> urls)
+{
+    QStringList recordings;
+    QMap<QString, QString> peaksFiles; // Recording (without suffix) -> peaks file
+    int skipped = 0;
+
+    // Sort dropped files into recordings and peaks files, using the names of
+    // the files written by savePeakPositions()
+    foreach (QUrl url, urls)
+    {
+        QFileInfo in(url.toLocalFile());
+        QString base = in.absolutePath() + "/" + in.completeBaseName();
+
+        if (in.suffix() != "txt" || base.endsWith("_ibi"))
+        {
+            skipped++;
+        }
+        else if (base.endsWith("_peaks"))
+        {
+            peaksFiles.insert(base.left(base.length() - 6), in.absoluteFilePath());
+        }
+        else
+        {
+            recordings << in.absoluteFilePath();
+        }
+    }
+
+    if (recordings.isEmpty())
+    {
+        QMessageBox::information(this, "Error", "No ecg signals among the dropped files");
+        return;
+    }
+
+    bool ok;
+    int sampleRate = QInputDialog::getInt(this, "Open Files",
+                                          "Sample rate of the " + QString::number(recordings.size()) + " ecg signals:",
+                                          fileSampleRate, 1, 65536, 1, &ok);
+
+    if (!ok) return;
+
+    // Loading starts in the background right away
+    foreach (QString recording, recordings)
+    {
+        QFileInfo in(recording);
+        QString base = in.absolutePath() + "/" + in.completeBaseName();
+
+        sessionQueue->enqueue(recording, peaksFiles.take(base), sampleRate, targetSampleRate());
+    }
+
+    skipped += peaksFiles.size();
+
+    openNextFile();
+
+    if (skipped > 0)
+    {
+        ui->statusBar->showMessage(QString::number(skipped) + " dropped files without matching ecg signal ignored", 4000);
+    }
+}
+
+void MainWindow::updateSampleRateLabel()
+{
+    QString text = "   Sample Rate: " + QString::number(ui->ecgPlot->getSampleRate()) + " Hz ";
+
+    if (!ui->ecgPlot->getSignal().isEmpty() && ui->ecgPlot->getSampleRate() != fileSampleRate)
+    {
+        text += "(resampled from " + QString::number(fileSampleRate) + " Hz) ";
+    }
+
+    sampleRateLabel->setText(text);
+}
+
+void MainWindow::closeEvent(QCloseEvent *event)
+{
+    saveSettings();
+    event->accept();
+}
+
+void MainWindow::saveSettings()
+{
+    QSettings settings(QDir::currentPath() + "/peakman.ini", QSettings::IniFormat);
+
+    settings.beginGroup("MainWindow");
+
+    // Save position and size of window
+    settings.setValue("size", size());
+    settings.setValue("pos", pos());
+
+    // Save sample rate for ecg data, and the rate signals are resampled to
+    settings.setValue("samplerate", fileSampleRate);
+    settings.setValue("resample", ui->resampleGroupBox->isChecked());
+    settings.setValue("resamplerate", ui->resampleSpinBox->value());
+
+    // Save settings for peak detection algorithm
+    settings.setValue("delta", ui->localThresholdSpinBox->value());
     settings.setValue("threshold", ui->globalThresholdSpinBox->value());
     settings.setValue("minrrintervall", ui->minRRIntervallSpinBox->value());
 
+    // Save baseline settings
+    settings.setValue("removebaseline", ui->removeBaselineCheckBox->isChecked());
+    settings.setValue("showbaseline", ui->showBaselineCheckBox->isChecked());
+
+    // Save filter settings
+    settings.setValue("filter", ui->filterGroupBox->isChecked());
+    settings.setValue("highpass", ui->highPassSpinBox->value());
+    settings.setValue("lowpass", ui->lowPassSpinBox->value());
+    settings.setValue("notch", ui->notchComboBox->currentIndex());
+
+    // Save whether to flip inverted signals
+    settings.setValue("detectpolarity", ui->menuDetectPolarity->isChecked());
+
+    // Save signal quality settings
+    settings.setValue("showquality", ui->showQualityCheckBox->isChecked());
+    settings.setValue("skipunusable", ui->skipUnusableCheckBox->isChecked());
+
     // Save whether to show global threshold
     settings.setValue("showthreshold", ui->showGlobalThresholdCheckBox->isChecked());
 
+    // Save whether to show the ecg-derived respiration
+    settings.setValue("showrespiration", ui->showRespirationCheckBox->isChecked());
+
+    // Save artifact detection method
+    settings.setValue("artifactmethod", ui->artifactMethodComboBox->currentIndex());
+    settings.setValue("compareartifacts", ui->compareArtifactsCheckBox->isChecked());
+
+    // Save histogram bin width and density
+    settings.setValue("histbinwidth", ui->histBinWidthSpinBox->value());
+    settings.setValue("showdensity", ui->showDensityCheckBox->isChecked());
+
+    // Save whether to show the heart rate
+    settings.setValue("showheartrate", ui->menuShowHeartRate->isChecked());
+
+    // Save sliding window of the HRV trend
+    settings.setValue("trendwindow", ui->trendWindowSpinBox->value());
+    settings.setValue("trendstep", ui->trendStepSpinBox->value());
+
+    // Save ensemble average window
+    settings.setValue("ensemblebefore", ui->ensembleBeforeSpinBox->value());
+    settings.setValue("ensembleafter", ui->ensembleAfterSpinBox->value());
+    settings.setValue("cleanbeats", ui->cleanBeatsCheckBox->isChecked());
+
+    // Save layout of the analysis panels
+    settings.setValue("windowstate", saveState());
+
+    // Save memory limit (in MB) for ecg signals before using a swap file
+    settings.setValue("memorylimit", ECGSignal::memoryLimit() / 1048576);
+
     settings.endGroup();
 }
 
@@ -526,8 +1605,11 @@ void MainWindow::loadSettings()
     resize(settings.value("size", QSize(1081, 693)).toSize());
     move(settings.value("pos", center).toPoint());
 
-    // Set sample rate for ecg data
-    ui->ecgPlot->setSampleRate(settings.value("samplerate", "").toInt());
+    // Set sample rate for ecg data, and the rate signals are resampled to
+    fileSampleRate = settings.value("samplerate", "").toInt();
+    ui->ecgPlot->setSampleRate(fileSampleRate);
+    ui->resampleGroupBox->setChecked(settings.value("resample", false).toBool());
+    ui->resampleSpinBox->setValue(settings.value("resamplerate", 250).toInt());
     updateSampleRateLabel();
 
     // Set settings for peak detection algorithm
@@ -535,9 +1617,55 @@ void MainWindow::loadSettings()
     ui->globalThresholdSpinBox->setValue(settings.value("threshold", "500").toInt());
     ui->minRRIntervallSpinBox->setValue(settings.value("minrrinterval", "270").toInt());
 
+    // Set baseline settings
+    ui->removeBaselineCheckBox->setChecked(settings.value("removebaseline", false).toBool());
+    ui->showBaselineCheckBox->setChecked(settings.value("showbaseline", false).toBool());
+
+    // Set filter settings
+    ui->filterGroupBox->setChecked(settings.value("filter", false).toBool());
+    ui->highPassSpinBox->setValue(settings.value("highpass", 0.5).toDouble());
+    ui->lowPassSpinBox->setValue(settings.value("lowpass", 40).toDouble());
+    ui->notchComboBox->setCurrentIndex(settings.value("notch", 0).toInt());
+
     // Set show global threshold
     ui->ecgPlot->setGlobalThresholdLineVisible(settings.value("showthreshold", true).toBool());
     ui->showGlobalThresholdCheckBox->setChecked(settings.value("showthreshold", true).toBool());
 
+    // Set whether to flip inverted signals
+    ui->menuDetectPolarity->setChecked(settings.value("detectpolarity", true).toBool());
+
+    // Set signal quality settings
+    ui->showQualityCheckBox->setChecked(settings.value("showquality", true).toBool());
+    ui->skipUnusableCheckBox->setChecked(settings.value("skipunusable", false).toBool());
+
+    // Set memory limit for ecg signals
+    ECGSignal::setMemoryLimit((qint64) settings.value("memorylimit", 512).toInt() * 1048576);
+
+    // Set whether to show the ecg-derived respiration
+    ui->showRespirationCheckBox->setChecked(settings.value("showrespiration", false).toBool());
+
+    // Set artifact detection method
+    ui->artifactMethodComboBox->setCurrentIndex(settings.value("artifactmethod", 0).toInt());
+    ui->compareArtifactsCheckBox->setChecked(settings.value("compareartifacts", false).toBool());
+
+    // Set histogram bin width and density
+    ui->histBinWidthSpinBox->setValue(settings.value("histbinwidth", 10).toInt());
+    ui->showDensityCheckBox->setChecked(settings.value("showdensity", false).toBool());
+
+    // Set whether to show the heart rate
+    ui->menuShowHeartRate->setChecked(settings.value("showheartrate", false).toBool());
+
+    // Set sliding window of the HRV trend
+    ui->trendWindowSpinBox->setValue(settings.value("trendwindow", 5).toInt());
+    ui->trendStepSpinBox->setValue(settings.value("trendstep", 30).toInt());
+
+    // Set ensemble average window
+    ui->ensembleBeforeSpinBox->setValue(settings.value("ensemblebefore", 250).toInt());
+    ui->ensembleAfterSpinBox->setValue(settings.value("ensembleafter", 450).toInt());
+    ui->cleanBeatsCheckBox->setChecked(settings.value("cleanbeats", true).toBool());
+
+    // Restore layout of the analysis panels
+    restoreState(settings.value("windowstate").toByteArray());
+
     settings.endGroup();
 }
@@ -21,10 +21,30 @@
 #define MAINWINDOW_H
 
 #include <QMainWindow>
+#include <QFutureWatcher>
 #include "qcustomplot.h"
 #include "ecgplot.h"
 #include "openfiledialog.h"
 #include "saveinterbeatintervalsdialog.h"
+#include "sessionqueue.h"
+#include "datafile.h"
+#include "ecgfilter.h"
+#include "baselinefilter.h"
+#include "resampler.h"
+#include "signalquality.h"
+#include "polarity.h"
+#include "ensembleaverager.h"
+#include "edrestimator.h"
+#include "heartratespline.h"
+#include "hrvmetrics.h"
+#include "hrvspectrum.h"
+#include "nonlinearhrv.h"
+#include "poincaredensity.h"
+#include "intervalhistogram.h"
+#include "slidinghrv.h"
+#include "artifactdetector.h"
+#include "beatcorrector.h"
+#include "artifactthumbnails.h"
 
 namespace Ui {
 class MainWindow;
@@ -46,11 +66,27 @@ private slots:
     void vertSliderChanged(int value);
 
     void getFileName();
+    void openNextFile(); // Opens the next recording of the session queue
     void closeCurrentFile();
     void saveInterbeatIntervals();
     void savePeakPositions();
+    void saveBeatFeatures(); // Per-beat feature table, one row per peak
+    void saveHeartRate(); // Evenly resampled heart rate
 
     void peakDetection();
+    void classifyBeats(); // Template matching, refines peaks and flags ectopic beats
+    void colorPeaks(int index); // Colors peaks by a beat feature
+    void averageBeats(); // Ensemble average around the peaks
+    void saveEnsembleAverage();
+    void computeSpectrum(); // Lomb-Scargle and resampled FFT spectrum of the interbeat intervals
+    void computeNonlinear(); // Sample entropy and detrended fluctuation analysis of the interbeat intervals
+    void computeTrend(); // Sliding-window HRV over the whole recording
+    void saveTrend();
+    void trendRangeChanged(QCPRange range); // Moves the ecg plot along with the trend plot
+    void invertSignal(); // Flips the polarity of the open signal
+    void updateFilter(); // Removes baseline wander and filters the ecg signal before peak detection
+    void showSignalQuality(int begin, int end); // Segments assessed in the background
+    void signalQualityFinished();
     // TODO: MOVE TO ECGPLOT
     //void peakdet(); // The peak detection algorithm
     //void insertPeakAtPos(QPoint position); // Used for inserting a peak at clicked position
@@ -59,8 +95,25 @@ private slots:
     //void deletePeaks(QList<QCPAbstractItem*> peaksToDelete); // Delete a list of peaks
 
     void setupIbiPlot();
+    void resetHistogram();
+    void updateHistogram(const PeakEdit &edit);
+    void resetRespiration(); // Recomputes the ecg-derived respiration of all peaks
+    void updateRespiration(const PeakEdit &edit); // Recomputes it around edited peaks
+    void resetHeartRate();
+    void updateHeartRate(const PeakEdit &edit);
+    void resetHrvMetrics();
+    void updateHrvMetrics(const PeakEdit &edit);
+    void showArtifactSummary(QString summary);
+    void resetPoincare();
+    void updatePoincare(const PeakEdit &edit);
     void jumpToSelection(); // Highlight a selected interbeat interval in ecg view
     void insertMissingPeaks(); // Subdivides an interbeat interval into shorter intervals
+    void correctAllArtifacts(); // Corrects every detected artifact at once, see BeatCorrector
+    void startReview(); // Renders thumbnails of the detected artifacts for the review queue
+    void renderThumbnails(); // Of the artifacts around the reviewed one
+    void showThumbnails(int begin, int end);
+    void reviewDecisionsChanged();
+    void correctAccepted();
 
     void aboutPeakMan();
 
@@ -72,10 +125,46 @@ private:
     void openEcgFile(); // Read a text file with ecg data
     void openPeaksFile();
     void openIbiFile();
+    void openFileBatch(QList<QUrl> urls); // Queues several recordings (and their peaks)
+    ECGSignal resampleSignal(const ECGSignal &signal); // Converts to the target rate, if resampling is enabled
+    void showEcgSignal(const ECGSignal &loaded);
+    void showPeaks(QVector<double> peaks_x);
     void dragEnterEvent(QDragEnterEvent *event); // Allows to drag something into the application
-    void dropEvent(QDropEvent *event); // Checks the dropped file and opens it
+    void dropEvent(QDropEvent *event); // Checks the dropped files and opens them
+
+    SessionQueue *sessionQueue;
+
+    EnsembleAverager::Result ensembleAverage;
+
+    EDREstimator edr;
+    void showRespiration();
+
+    HeartRateSpline heartRate;
+
+    HRVMetrics hrvMetrics;
+    void showHrvMetrics();
+
+    PoincareDensity poincare;
+    void showPoincare(bool rescale);
+
+    IntervalHistogram histogram; // Shared by the histogram and interbeat interval plots
+
+    SlidingHRV::Result trend;
+    QVector<double> beatTimes() const; // Peaks, or the cumulated intervals of an interval file
+
+    QFutureWatcher<SignalQuality::Segment> *qualityWatcher;
+    void startSignalQuality(const ECGSignal &signal);
+    void stopSignalQuality();
+
+    QFutureWatcher<QImage> *thumbnailWatcher;
+    QVector<double> reviewPeaks; // Peaks the reviewed interval indices refer to
+    QVector<int> thumbnailBatch; // Review candidates of the thumbnails being rendered
+    void stopReview();
+    void applyCorrection(const QVector<int> &artifacts);
 
     //int sampleRate; // Stores the samplerate in hertz
+    int fileSampleRate; // Sample rate of the open file, the ecg plot has the resampled rate
+    int targetSampleRate() const; // 0 if resampling is disabled
     QLabel *sampleRateLabel; // Used for displaying the samplerate in the top right corner of the gui
     void updateSampleRateLabel(); // Updates the samplerate label
 
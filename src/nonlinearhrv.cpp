@@ -0,0 +1,307 @@
+/*
+ * Copyright (C) 2014-2015 Daniel Gromer
+ *
+ * This file is part of PeakMan.
+ *
+ * PeakMan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * PeakMan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PeakMan.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "nonlinearhrv.h"
+#include <QtConcurrentMap>
+#include <QtNumeric>
+#include <qmath.h>
+#include <algorithm>
+
+// Templates per parallel work item of sample entropy
+static const int ChunkTemplates = 4096;
+
+// Box sizes of DFA
+static const int ShortFrom = 4;
+static const int ShortTo = 16;
+static const int LongTo = 64;
+
+struct Template
+{
+    qint64 cell; // Grid cell of the first two intervals
+    int index;
+
+    bool operator<(const Template &other) const
+    {
+        return cell < other.cell || (cell == other.cell && index < other.index);
+    }
+};
+
+struct EntropyChunk
+{
+    const QVector<double> *x;
+    const QVector<Template> *grid; // Sorted by cell, then index
+    const QVector<qint64> *cellOf; // Cell of each template index
+    int m;
+    double r;
+    int first; // Templates of this chunk
+    int last;
+
+    qint64 matches; // Pairs matching over m intervals
+    qint64 extended; // Pairs also matching in the next interval
+};
+
+static qint64 cellKey(qint64 cx, qint64 cy)
+{
+    // Cells are offset to be non-negative, 2^31 cells per axis is plenty
+    return (cx << 32) + cy;
+}
+
+static void countChunk(EntropyChunk &chunk)
+{
+    const double *x = chunk.x->constData();
+    const QVector<Template> &grid = *chunk.grid;
+    int m = chunk.m;
+    double r = chunk.r;
+
+    chunk.matches = 0;
+    chunk.extended = 0;
+
+    for (int i = chunk.first; i < chunk.last; i++)
+    {
+        qint64 cell = chunk.cellOf->at(i);
+        qint64 cx = cell >> 32;
+        qint64 cy = cell & 0xffffffff;
+
+        for (qint64 dx = -1; dx <= 1; dx++)
+        {
+            for (qint64 dy = (m > 1 ? -1 : 0); dy <= (m > 1 ? 1 : 0); dy++)
+            {
+                // Templates of this cell after i, each pair is counted once
+                Template from = { cellKey(cx + dx, cy + dy), i + 1 };
+                Template to = { cellKey(cx + dx, cy + dy) + 1, 0 };
+
+                QVector<Template>::const_iterator begin = std::lower_bound(grid.constBegin(), grid.constEnd(), from);
+                QVector<Template>::const_iterator end = std::lower_bound(begin, grid.constEnd(), to);
+
+                for (QVector<Template>::const_iterator it = begin; it != end; ++it)
+                {
+                    int j = it->index;
+                    int k = 0;
+
+                    while (k < m && qAbs(x[i + k] - x[j + k]) <= r) k++;
+
+                    if (k < m) continue;
+
+                    chunk.matches++;
+
+                    if (qAbs(x[i + m] - x[j + m]) <= r) chunk.extended++;
+                }
+            }
+        }
+    }
+}
+
+double NonlinearHRV::sampleEntropy(const QVector<double> &intervals, int m, double tolerance)
+{
+    int n = intervals.size();
+
+    // Templates of length m + 1 must fit, the same ones are used for length m
+    int templates = n - m;
+
+    if (m < 1 || templates < 2) return qQNaN();
+
+    double mean = 0, squares = 0;
+
+    for (int i = 0; i < n; i++)
+    {
+        mean += intervals[i];
+    }
+
+    mean /= n;
+
+    for (int i = 0; i < n; i++)
+    {
+        squares += (intervals[i] - mean) * (intervals[i] - mean);
+    }
+
+    double r = tolerance * qSqrt(squares / (n - 1));
+
+    if (r <= 0) return qQNaN();
+
+    // Grid cells of r over the first (two) intervals of each template,
+    // matching templates are at most one cell apart
+    double low = *std::min_element(intervals.constBegin(), intervals.constEnd());
+
+    QVector<Template> grid(templates);
+    QVector<qint64> cellOf(templates);
+
+    for (int i = 0; i < templates; i++)
+    {
+        qint64 cx = (qint64) ((intervals[i] - low) / r) + 1;
+        qint64 cy = m > 1 ? (qint64) ((intervals[i + 1] - low) / r) + 1 : 0;
+
+        grid[i].cell = cellKey(cx, cy);
+        grid[i].index = i;
+        cellOf[i] = grid[i].cell;
+    }
+
+    std::sort(grid.begin(), grid.end());
+
+    QVector<EntropyChunk> chunks;
+
+    for (int first = 0; first < templates; first += ChunkTemplates)
+    {
+        EntropyChunk chunk;
+        chunk.x = &intervals;
+        chunk.grid = &grid;
+        chunk.cellOf = &cellOf;
+        chunk.m = m;
+        chunk.r = r;
+        chunk.first = first;
+        chunk.last = qMin(templates, first + ChunkTemplates);
+
+        chunks << chunk;
+    }
+
+    QtConcurrent::blockingMap(chunks, countChunk);
+
+    qint64 matches = 0, extended = 0;
+
+    for (int c = 0; c < chunks.size(); c++)
+    {
+        matches += chunks[c].matches;
+        extended += chunks[c].extended;
+    }
+
+    if (matches == 0 || extended == 0) return qQNaN();
+
+    return -qLn((double) extended / matches);
+}
+
+struct FluctuationTask
+{
+    const QVector<double> *profile;
+    int boxSize;
+    double fluctuation;
+};
+
+static void fluctuation(FluctuationTask &task)
+{
+    const double *y = task.profile->constData();
+    int n = task.boxSize;
+    int boxes = task.profile->size() / n;
+
+    // Sums of the local index u = 0 .. n - 1, the same for every box
+    double su = n * (n - 1) / 2.0;
+    double suu = (n - 1) * n * (2 * n - 1) / 6.0;
+    double varu = suu - su * su / n;
+
+    double residual = 0;
+
+    for (int b = 0; b < boxes; b++)
+    {
+        const double *box = y + b * n;
+        double sy = 0, suy = 0;
+
+        for (int u = 0; u < n; u++)
+        {
+            sy += box[u];
+            suy += u * box[u];
+        }
+
+        // Least squares line, then the squared residuals around it
+        double slope = (suy - su * sy / n) / varu;
+        double intercept = (sy - slope * su) / n;
+
+        for (int u = 0; u < n; u++)
+        {
+            double e = box[u] - intercept - slope * u;
+            residual += e * e;
+        }
+    }
+
+    task.fluctuation = boxes > 0 ? qSqrt(residual / (boxes * n)) : qQNaN();
+}
+
+// Slope of log F over log n for box sizes [from, to]
+static double scalingExponent(const NonlinearHRV::DFA &dfa, int from, int to)
+{
+    double sx = 0, sy = 0, sxx = 0, sxy = 0;
+    int count = 0;
+
+    for (int i = 0; i < dfa.boxSize.size(); i++)
+    {
+        if (dfa.boxSize[i] < from || dfa.boxSize[i] > to || !(dfa.fluctuation[i] > 0)) continue;
+
+        double lx = qLn(dfa.boxSize[i]);
+        double ly = qLn(dfa.fluctuation[i]);
+
+        sx += lx;
+        sy += ly;
+        sxx += lx * lx;
+        sxy += lx * ly;
+        count++;
+    }
+
+    if (count < 2) return qQNaN();
+
+    return (sxy - sx * sy / count) / (sxx - sx * sx / count);
+}
+
+NonlinearHRV::DFA NonlinearHRV::detrendedFluctuation(const QVector<double> &intervals)
+{
+    DFA dfa;
+    dfa.alpha1 = qQNaN();
+    dfa.alpha2 = qQNaN();
+
+    int n = intervals.size();
+
+    if (n < 2 * ShortFrom) return dfa;
+
+    // Integrated profile of the series around its mean
+    double mean = 0;
+
+    for (int i = 0; i < n; i++) mean += intervals[i];
+
+    mean /= n;
+
+    QVector<double> profile(n);
+    double sum = 0;
+
+    for (int i = 0; i < n; i++)
+    {
+        sum += intervals[i] - mean;
+        profile[i] = sum;
+    }
+
+    QVector<FluctuationTask> tasks;
+
+    for (int size = ShortFrom; size <= qMin(LongTo, n / 2); size++)
+    {
+        FluctuationTask task;
+        task.profile = &profile;
+        task.boxSize = size;
+        task.fluctuation = 0;
+
+        tasks << task;
+    }
+
+    QtConcurrent::blockingMap(tasks, fluctuation);
+
+    for (int i = 0; i < tasks.size(); i++)
+    {
+        dfa.boxSize << tasks[i].boxSize;
+        dfa.fluctuation << tasks[i].fluctuation;
+    }
+
+    dfa.alpha1 = scalingExponent(dfa, ShortFrom, ShortTo);
+    dfa.alpha2 = scalingExponent(dfa, ShortTo, LongTo);
+
+    return dfa;
+}
@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2014-2015 Daniel Gromer
+ *
+ * This file is part of PeakMan.
+ *
+ * PeakMan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * PeakMan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PeakMan.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NONLINEARHRV_H
+#define NONLINEARHRV_H
+
+#include <QVector>
+
+// Nonlinear HRV measures of an interbeat interval series.
+//
+// Sample entropy counts pairs of templates (runs of m intervals) that match
+// within a tolerance r. Instead of comparing all pairs, templates are put in
+// a grid of r-sized cells over their first two intervals, and each template
+// is only compared with the ones in the neighbouring cells. Templates are
+// split into chunks counted in parallel.
+//
+// Detrended fluctuation analysis integrates the series into a profile,
+// fits a line to each box of the profile and takes the RMS of the residuals
+// per box size. The box sizes are computed in parallel, alpha1 and alpha2 are
+// the slopes of log F(n) over the short (4-16) and long (16-64) box sizes.
+class NonlinearHRV
+{
+public:
+    struct DFA
+    {
+        QVector<double> boxSize;
+        QVector<double> fluctuation;
+        double alpha1;
+        double alpha2;
+    };
+
+    static double sampleEntropy(const QVector<double> &intervals, int m = 2, double tolerance = 0.2); // Tolerance in standard deviations, NaN if undefined
+    static DFA detrendedFluctuation(const QVector<double> &intervals);
+};
+
+#endif // NONLINEARHRV_H
@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2014-2015 Daniel Gromer
+ *
+ * This file is part of PeakMan.
+ *
+ * PeakMan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * PeakMan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PeakMan.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "peakedit.h"
+
+const int PeakEdit::Context;
+
+PeakEdit::PeakEdit()
+{
+    start = 0;
+    removed = 0;
+    inserted = 0;
+    peaks = 0;
+    lead = 0;
+    trail = 0;
+}
+
+bool PeakEdit::isEmpty() const
+{
+    return removed == 0 && inserted == 0;
+}
+
+int PeakEdit::sizeBefore() const
+{
+    return peaks - inserted + removed;
+}
+
+void PeakEdit::splice(QVector<double> &rows, double value) const
+{
+    // Only the rows after the edit move, and only by the size difference
+    if (inserted < removed)
+    {
+        rows.remove(start, removed - inserted);
+    }
+    else if (inserted > removed)
+    {
+        rows.insert(start, inserted - removed, value);
+    }
+
+    double *row = rows.data() + start;
+
+    for (int i = 0; i < inserted; i++)
+    {
+        row[i] = value;
+    }
+}
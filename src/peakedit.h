@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2014-2015 Daniel Gromer
+ *
+ * This file is part of PeakMan.
+ *
+ * PeakMan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * PeakMan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PeakMan.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PEAKEDIT_H
+#define PEAKEDIT_H
+
+#include <QVector>
+
+// Rows of the PeakStore replaced by an edit, with the positions around them
+// before and after it. Classes that keep values per beat or sums over the
+// intervals update them from the edit instead of keeping their own copy of
+// the peaks to compare with.
+class PeakEdit
+{
+public:
+    // Unchanged neighbours on each side, enough for the intervals and the
+    // successive differences that change with the replaced rows
+    static const int Context = 2;
+
+    PeakEdit();
+
+    int start; // First replaced row
+    int removed; // Rows before the edit
+    int inserted; // Rows after the edit
+    int peaks; // Size of the store, after the edit once it is complete
+
+    // Positions of the rows [start - lead, start + removed + trail) before
+    // the edit and [start - lead, start + inserted + trail) after it
+    int lead;
+    int trail;
+    QVector<double> before;
+    QVector<double> after;
+
+    bool isEmpty() const;
+    int sizeBefore() const; // Size of the store before the edit
+    void splice(QVector<double> &rows, double value = 0) const; // Replaces the removed rows by inserted ones set to value
+};
+
+#endif // PEAKEDIT_H
@@ -4,7 +4,7 @@
 #
 #-------------------------------------------------
 
-QT       += core gui printsupport
+QT       += core gui printsupport concurrent
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
@@ -19,7 +19,42 @@ SOURCES += main.cpp\
     openfiledialog.cpp \
     ibiplot.cpp \
     histplot.cpp \
-    saveinterbeatintervalsdialog.cpp
+    saveinterbeatintervalsdialog.cpp \
+    ecgsignal.cpp \
+    signalgraph.cpp \
+    peakstore.cpp \
+    peakmarkers.cpp \
+    datafile.cpp \
+    sessionqueue.cpp \
+    ecgfilter.cpp \
+    runningmedian.cpp \
+    baselinefilter.cpp \
+    resampler.cpp \
+    fft.cpp \
+    signalquality.cpp \
+    qualityshading.cpp \
+    polarity.cpp \
+    templatematcher.cpp \
+    ensembleaverager.cpp \
+    ensembleplot.cpp \
+    beatfeatures.cpp \
+    edrestimator.cpp \
+    heartratespline.cpp \
+    hrvmetrics.cpp \
+    hrvspectrum.cpp \
+    spectrumplot.cpp \
+    slidinghrv.cpp \
+    trendplot.cpp \
+    nonlinearhrv.cpp \
+    poincaredensity.cpp \
+    poincareplot.cpp \
+    runningquantile.cpp \
+    artifactdetector.cpp \
+    beatcorrector.cpp \
+    artifactthumbnails.cpp \
+    artifactreview.cpp \
+    intervalhistogram.cpp \
+    peakedit.cpp
 
 HEADERS  += mainwindow.h \
     qcustomplot.h \
@@ -27,7 +62,42 @@ HEADERS  += mainwindow.h \
     openfiledialog.h \
     ibiplot.h \
     histplot.h \
-    saveinterbeatintervalsdialog.h
+    saveinterbeatintervalsdialog.h \
+    ecgsignal.h \
+    signalgraph.h \
+    peakstore.h \
+    peakmarkers.h \
+    datafile.h \
+    sessionqueue.h \
+    ecgfilter.h \
+    runningmedian.h \
+    baselinefilter.h \
+    resampler.h \
+    fft.h \
+    signalquality.h \
+    qualityshading.h \
+    polarity.h \
+    templatematcher.h \
+    ensembleaverager.h \
+    ensembleplot.h \
+    beatfeatures.h \
+    edrestimator.h \
+    heartratespline.h \
+    hrvmetrics.h \
+    hrvspectrum.h \
+    spectrumplot.h \
+    slidinghrv.h \
+    trendplot.h \
+    nonlinearhrv.h \
+    poincaredensity.h \
+    poincareplot.h \
+    runningquantile.h \
+    artifactdetector.h \
+    beatcorrector.h \
+    artifactthumbnails.h \
+    artifactreview.h \
+    intervalhistogram.h \
+    peakedit.h
 
 FORMS    += mainwindow.ui \
     openfiledialog.ui \
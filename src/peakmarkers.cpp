@@ -0,0 +1,194 @@
+/*
+ * Copyright (C) 2014-2015 Daniel Gromer
+ *
+ * This file is part of PeakMan.
+ *
+ * PeakMan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * PeakMan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PeakMan.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "peakmarkers.h"
+#include <QtAlgorithms>
+
+// Distinct colors when peaks are colored by a feature, peaks with the same
+// color are drawn together
+static const int ColorLevels = 16;
+
+PeakMarkers::PeakMarkers(QCPAxis *keyAxis, QCPAxis *valueAxis) : QCPAbstractPlottable(keyAxis, valueAxis)
+{
+    peaks = 0;
+    features = 0;
+    colorFeature = -1;
+    gradient = QCPColorGradient(QCPColorGradient::gpJet);
+    gradient.setLevelCount(ColorLevels);
+
+    // Selection of single peaks is handled by ECGPlot
+    setSelectable(false);
+}
+
+PeakMarkers::~PeakMarkers()
+{
+
+}
+
+void PeakMarkers::setPeaks(const PeakStore *peaks)
+{
+    this->peaks = peaks;
+}
+
+void PeakMarkers::setEctopicPen(const QPen &pen)
+{
+    ectopicPen = pen;
+}
+
+void PeakMarkers::setFeatureColors(const BeatFeatures *features, int feature, const QCPRange &range)
+{
+    this->features = features;
+    colorFeature = feature;
+    colorRange = range;
+}
+
+void PeakMarkers::clearData()
+{
+    peaks = 0;
+}
+
+double PeakMarkers::selectTest(const QPointF &pos, bool onlySelectable, QVariant *details) const
+{
+    Q_UNUSED(pos)
+    Q_UNUSED(onlySelectable)
+    Q_UNUSED(details)
+
+    return -1;
+}
+
+void PeakMarkers::draw(QCPPainter *painter)
+{
+    if (!peaks || peaks->isEmpty() || !mKeyAxis) return;
+
+    QCPRange range = mKeyAxis.data()->range();
+    QRect rect = clipRect();
+
+    int first = peaks->lowerBound(range.lower);
+    int last = peaks->lowerBound(range.upper);
+
+    QVector<QLineF> lines;
+    QVector<QLineF> selectedLines;
+    QVector<QLineF> ectopicLines;
+    QVector<QVector<QLineF> > colorLines(ColorLevels);
+    double lastX = -1;
+
+    // Rows of the feature table are sorted like the peaks, so one cursor
+    // follows the visible peaks through the table
+    bool colored = features && colorFeature >= 0 && !features->isEmpty() && first < last;
+    QVector<double> rows;
+    QVector<double> values;
+    int row = 0;
+
+    if (colored)
+    {
+        rows = features->positions(); // Shallow copies
+        values = features->column((BeatFeatures::Feature) colorFeature);
+        row = qLowerBound(rows.constBegin(), rows.constEnd(), peaks->at(first)) - rows.constBegin();
+    }
+
+    for (int i = first; i < last; i++)
+    {
+        double x = mKeyAxis.data()->coordToPixel(peaks->at(i));
+
+        if (peaks->isSelected(i))
+        {
+            selectedLines << QLineF(x, rect.top(), x, rect.bottom());
+        }
+        else if (peaks->isEctopic(i))
+        {
+            // Few and important, never skipped
+            ectopicLines << QLineF(x, rect.top(), x, rect.bottom());
+        }
+        else if (lines.isEmpty() || x - lastX >= 1)
+        {
+            QLineF line(x, rect.top(), x, rect.bottom());
+            int level = -1;
+
+            if (colored)
+            {
+                while (row < rows.size() && rows[row] < peaks->at(i)) row++;
+
+                if (row < rows.size() && rows[row] == peaks->at(i))
+                {
+                    double position = colorRange.size() > 0 ? (values[row] - colorRange.lower) / colorRange.size() : 0.5;
+                    level = qBound(0, (int) (position * ColorLevels), ColorLevels - 1);
+                }
+            }
+
+            // Skip peaks that would end up on the same pixel
+            if (level >= 0)
+            {
+                colorLines[level] << line;
+            }
+            else
+            {
+                lines << line;
+            }
+
+            lastX = x;
+        }
+    }
+
+    applyDefaultAntialiasingHint(painter);
+
+    painter->setPen(mPen);
+    painter->drawLines(lines);
+
+    for (int level = 0; level < ColorLevels; level++)
+    {
+        if (colorLines[level].isEmpty()) continue;
+
+        QPen pen = mPen;
+        pen.setColor(QColor::fromRgb(gradient.color((level + 0.5) / ColorLevels, QCPRange(0, 1))));
+        painter->setPen(pen);
+        painter->drawLines(colorLines[level]);
+    }
+
+    painter->setPen(ectopicPen);
+    painter->drawLines(ectopicLines);
+
+    painter->setPen(mSelectedPen);
+    painter->drawLines(selectedLines);
+}
+
+void PeakMarkers::drawLegendIcon(QCPPainter *painter, const QRectF &rect) const
+{
+    applyDefaultAntialiasingHint(painter);
+    painter->setPen(mPen);
+    painter->drawLine(QLineF(rect.center().x(), rect.top(), rect.center().x(), rect.bottom()));
+}
+
+QCPRange PeakMarkers::getKeyRange(bool &foundRange, SignDomain inSignDomain) const
+{
+    Q_UNUSED(inSignDomain)
+
+    foundRange = peaks && !peaks->isEmpty();
+
+    return foundRange ? QCPRange(peaks->first(), peaks->last()) : QCPRange();
+}
+
+QCPRange PeakMarkers::getValueRange(bool &foundRange, SignDomain inSignDomain) const
+{
+    Q_UNUSED(inSignDomain)
+
+    // Peaks span the whole value axis
+    foundRange = false;
+
+    return QCPRange();
+}
@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2014-2015 Daniel Gromer
+ *
+ * This file is part of PeakMan.
+ *
+ * PeakMan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * PeakMan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PeakMan.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PEAKMARKERS_H
+#define PEAKMARKERS_H
+
+#include "qcustomplot.h"
+#include "peakstore.h"
+#include "beatfeatures.h"
+
+// Plottable that draws the peaks of a PeakStore as vertical lines. Only peaks
+// in the visible range are drawn, at most one unselected peak per pixel.
+class PeakMarkers : public QCPAbstractPlottable
+{
+    Q_OBJECT
+
+public:
+    explicit PeakMarkers(QCPAxis *keyAxis, QCPAxis *valueAxis);
+    ~PeakMarkers();
+
+    void setPeaks(const PeakStore *peaks);
+    void setEctopicPen(const QPen &pen);
+
+    // Colors peaks by one column of a feature table, peaks that are not in
+    // the table keep the normal pen. A feature of -1 turns coloring off.
+    void setFeatureColors(const BeatFeatures *features, int feature, const QCPRange &range);
+
+    virtual void clearData();
+    virtual double selectTest(const QPointF &pos, bool onlySelectable, QVariant *details = 0) const;
+
+protected:
+    virtual void draw(QCPPainter *painter);
+    virtual void drawLegendIcon(QCPPainter *painter, const QRectF &rect) const;
+    virtual QCPRange getKeyRange(bool &foundRange, SignDomain inSignDomain = sdBoth) const;
+    virtual QCPRange getValueRange(bool &foundRange, SignDomain inSignDomain = sdBoth) const;
+
+private:
+    const PeakStore *peaks;
+    QPen ectopicPen;
+
+    const BeatFeatures *features;
+    int colorFeature;
+    QCPRange colorRange;
+    QCPColorGradient gradient;
+};
+
+#endif // PEAKMARKERS_H
@@ -0,0 +1,233 @@
+/*
+ * Copyright (C) 2014-2015 Daniel Gromer
+ *
+ * This file is part of PeakMan.
+ *
+ * PeakMan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * PeakMan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PeakMan.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "peakstore.h"
+#include <QtAlgorithms>
+
+PeakStore::PeakStore()
+{
+
+}
+
+int PeakStore::size() const
+{
+    return pos.size();
+}
+
+bool PeakStore::isEmpty() const
+{
+    return pos.isEmpty();
+}
+
+double PeakStore::at(int i) const
+{
+    return pos.at(i);
+}
+
+double PeakStore::first() const
+{
+    return pos.first();
+}
+
+double PeakStore::last() const
+{
+    return pos.last();
+}
+
+QVector<double> PeakStore::positions() const
+{
+    return pos;
+}
+
+QVector<quint8> PeakStore::flagValues() const
+{
+    return flags;
+}
+
+int PeakStore::lowerBound(double position) const
+{
+    return qLowerBound(pos.constBegin(), pos.constEnd(), position) - pos.constBegin();
+}
+
+int PeakStore::nearest(double position) const
+{
+    if (pos.isEmpty()) return -1;
+
+    int i = lowerBound(position);
+
+    if (i == pos.size()) return i - 1;
+    if (i > 0 && position - pos[i - 1] < pos[i] - position) return i - 1;
+
+    return i;
+}
+
+int PeakStore::insert(double position)
+{
+    int i = lowerBound(position);
+
+    // Never store the same position twice
+    if (i < pos.size() && pos[i] == position) return i;
+
+    pos.insert(i, position);
+    flags.insert(i, 0);
+
+    return i;
+}
+
+void PeakStore::remove(int i)
+{
+    pos.remove(i);
+    flags.remove(i);
+}
+
+int PeakStore::removeSelected()
+{
+    // Compact both vectors in one pass
+    int n = 0;
+
+    for (int i = 0; i < pos.size(); i++)
+    {
+        if (!(flags[i] & Selected))
+        {
+            pos[n] = pos[i];
+            flags[n] = flags[i];
+            n++;
+        }
+    }
+
+    int removed = pos.size() - n;
+
+    pos.resize(n);
+    flags.resize(n);
+
+    return removed;
+}
+
+void PeakStore::setPositions(const QVector<double> &sortedPositions)
+{
+    pos = sortedPositions;
+    flags = QVector<quint8>(pos.size(), 0);
+}
+
+void PeakStore::setPositions(const QVector<double> &sortedPositions, const QVector<quint8> &peakFlags)
+{
+    pos = sortedPositions;
+    flags = peakFlags;
+}
+
+void PeakStore::clear()
+{
+    pos.clear();
+    flags.clear();
+}
+
+PeakEdit PeakStore::beginEdit(double from, double to) const
+{
+    PeakEdit edit;
+    edit.start = lowerBound(from);
+    edit.removed = qUpperBound(pos.constBegin(), pos.constEnd(), to) - pos.constBegin() - edit.start;
+    edit.lead = qMin(edit.start, (int) PeakEdit::Context);
+    edit.trail = qMin(pos.size() - edit.start - edit.removed, (int) PeakEdit::Context);
+    edit.before = pos.mid(edit.start - edit.lead, edit.lead + edit.removed + edit.trail);
+    edit.peaks = pos.size();
+
+    return edit;
+}
+
+void PeakStore::endEdit(PeakEdit &edit) const
+{
+    // Rows before from and after to are the same as before the edit
+    edit.inserted = pos.size() - (edit.peaks - edit.removed);
+    edit.peaks = pos.size();
+    edit.after = pos.mid(edit.start - edit.lead, edit.lead + edit.inserted + edit.trail);
+}
+
+bool PeakStore::isSelected(int i) const
+{
+    return flags.at(i) & Selected;
+}
+
+void PeakStore::setSelected(int i, bool selected)
+{
+    if (selected)
+    {
+        flags[i] |= Selected;
+    }
+    else
+    {
+        flags[i] &= ~Selected;
+    }
+}
+
+void PeakStore::selectRange(double from, double to)
+{
+    for (int i = lowerBound(from); i < pos.size() && pos[i] <= to; i++)
+    {
+        flags[i] |= Selected;
+    }
+}
+
+void PeakStore::clearSelection()
+{
+    for (int i = 0; i < flags.size(); i++)
+    {
+        flags[i] &= ~Selected;
+    }
+}
+
+int PeakStore::selectedCount() const
+{
+    int n = 0;
+
+    for (int i = 0; i < flags.size(); i++)
+    {
+        if (flags[i] & Selected) n++;
+    }
+
+    return n;
+}
+
+bool PeakStore::isEctopic(int i) const
+{
+    return flags.at(i) & Ectopic;
+}
+
+void PeakStore::setEctopic(int i, bool ectopic)
+{
+    if (ectopic)
+    {
+        flags[i] |= Ectopic;
+    }
+    else
+    {
+        flags[i] &= ~Ectopic;
+    }
+}
+
+int PeakStore::ectopicCount() const
+{
+    int n = 0;
+
+    for (int i = 0; i < flags.size(); i++)
+    {
+        if (flags[i] & Ectopic) n++;
+    }
+
+    return n;
+}
@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2014-2015 Daniel Gromer
+ *
+ * This file is part of PeakMan.
+ *
+ * PeakMan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * PeakMan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PeakMan.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PEAKSTORE_H
+#define PEAKSTORE_H
+
+#include <QVector>
+#include "peakedit.h"
+
+// Sorted list of peak positions (in seconds) with a set of flags per peak.
+class PeakStore
+{
+public:
+    enum Flag { Selected = 0x1, Ectopic = 0x2 };
+
+    PeakStore();
+
+    int size() const;
+    bool isEmpty() const;
+    double at(int i) const;
+    double first() const;
+    double last() const;
+    QVector<double> positions() const;
+    QVector<quint8> flagValues() const; // Flags of all peaks, see Flag
+
+    int lowerBound(double position) const; // Index of first peak >= position
+    int nearest(double position) const; // Index of closest peak, -1 if empty
+
+    int insert(double position);
+    void remove(int i);
+    int removeSelected();
+    void setPositions(const QVector<double> &sortedPositions);
+    void setPositions(const QVector<double> &sortedPositions, const QVector<quint8> &peakFlags); // Keeps the flags
+    void clear();
+
+    // Rows within [from, to] before an edit, and after it with endEdit()
+    PeakEdit beginEdit(double from, double to) const;
+    void endEdit(PeakEdit &edit) const;
+
+    bool isSelected(int i) const;
+    void setSelected(int i, bool selected);
+    void selectRange(double from, double to);
+    void clearSelection();
+    int selectedCount() const;
+
+    bool isEctopic(int i) const;
+    void setEctopic(int i, bool ectopic);
+    int ectopicCount() const;
+
+private:
+    QVector<double> pos;
+    QVector<quint8> flags;
+};
+
+#endif // PEAKSTORE_H
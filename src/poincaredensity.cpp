@@ -0,0 +1,164 @@
+/*
+ * Copyright (C) 2014-2015 Daniel Gromer
+ *
+ * This file is part of PeakMan.
+ *
+ * PeakMan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * PeakMan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PeakMan.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "poincaredensity.h"
+#include <qmath.h>
+#include <algorithm>
+
+// Grid of 10 ms bins, covers heart rates of 30-300 bpm
+static const double Lower = 200;
+static const double Upper = 2000;
+static const int Bins = 180;
+
+PoincareDensity::PoincareDensity()
+{
+    clear();
+}
+
+void PoincareDensity::reset(const QVector<double> &peaks)
+{
+    clear();
+
+    if (peaks.size() > 1) shift = peaks[1] - peaks[0];
+
+    accumulate(peaks, 0, peaks.size() - 1, 1);
+}
+
+void PoincareDensity::update(const QVector<double> &peaks, const PeakEdit &edit)
+{
+    // The sums missed an edit, start over
+    if (pairs != qMax(edit.sizeBefore() - 2, 0) || peaks.size() != edit.peaks)
+    {
+        reset(peaks);
+        return;
+    }
+
+    // Pairs around the edited beats change, the old ones come from the
+    // positions before the edit and the new ones from those after it
+    int first = edit.lead - 1;
+
+    accumulate(edit.before, first, qMin(edit.lead + edit.removed, edit.before.size() - 1), -1);
+    accumulate(edit.after, first, qMin(edit.lead + edit.inserted, edit.after.size() - 1), 1);
+}
+
+void PoincareDensity::clear()
+{
+    counts.fill(0, Bins * Bins);
+    shift = 0;
+    pairs = 0;
+    sumX = 0;
+    sumY = 0;
+    sumXX = 0;
+    sumYY = 0;
+    sumXY = 0;
+}
+
+bool PoincareDensity::isEmpty() const
+{
+    return pairs == 0;
+}
+
+int PoincareDensity::pairCount() const
+{
+    return pairs;
+}
+
+double PoincareDensity::sd1() const
+{
+    if (pairs < 2) return 0;
+
+    // Spread across the identity line, half the variance of y - x
+    double varX = sumXX - sumX * sumX / pairs;
+    double varY = sumYY - sumY * sumY / pairs;
+    double cov = sumXY - sumX * sumY / pairs;
+
+    return qSqrt(qMax(0.0, (varX + varY - 2 * cov) / (2 * (pairs - 1)))) * 1000;
+}
+
+double PoincareDensity::sd2() const
+{
+    if (pairs < 2) return 0;
+
+    // Spread along the identity line, half the variance of y + x
+    double varX = sumXX - sumX * sumX / pairs;
+    double varY = sumYY - sumY * sumY / pairs;
+    double cov = sumXY - sumX * sumY / pairs;
+
+    return qSqrt(qMax(0.0, (varX + varY + 2 * cov) / (2 * (pairs - 1)))) * 1000;
+}
+
+int PoincareDensity::getBins() const
+{
+    return Bins;
+}
+
+double PoincareDensity::getLower() const
+{
+    return Lower;
+}
+
+double PoincareDensity::getUpper() const
+{
+    return Upper;
+}
+
+int PoincareDensity::count(int column, int row) const
+{
+    return counts[row * Bins + column];
+}
+
+int PoincareDensity::maxCount() const
+{
+    return counts.isEmpty() ? 0 : *std::max_element(counts.constBegin(), counts.constEnd());
+}
+
+void PoincareDensity::accumulate(const QVector<double> &beats, int first, int last, int sign)
+{
+    int n = beats.size();
+
+    // Pairs of an interval and the one before it, for the intervals ending at
+    // beats first + 1 to last and the interval after them
+    for (int i = qMax(first + 1, 2); i <= qMin(last + 1, n - 1); i++)
+    {
+        double x = beats[i - 1] - beats[i - 2];
+        double y = beats[i] - beats[i - 1];
+
+        int column = bin(x * 1000);
+        int row = bin(y * 1000);
+
+        if (column >= 0 && row >= 0) counts[row * Bins + column] += sign;
+
+        x -= shift;
+        y -= shift;
+
+        pairs += sign;
+        sumX += sign * x;
+        sumY += sign * y;
+        sumXX += sign * x * x;
+        sumYY += sign * y * y;
+        sumXY += sign * x * y;
+    }
+}
+
+int PoincareDensity::bin(double interval) const
+{
+    if (interval < Lower || interval >= Upper) return -1;
+
+    return (int) ((interval - Lower) / (Upper - Lower) * Bins);
+}
@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2014-2015 Daniel Gromer
+ *
+ * This file is part of PeakMan.
+ *
+ * PeakMan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * PeakMan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PeakMan.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef POINCAREDENSITY_H
+#define POINCAREDENSITY_H
+
+#include <QVector>
+#include "peakedit.h"
+
+// Poincaré plot of each interbeat interval against the next one, binned into
+// a fixed grid of counts. SD1 and SD2 come from running sums over the pairs.
+// Like the HRV metrics an edit takes the pairs around the edited beats out of
+// the grid and the sums and adds the new ones, both from the positions around
+// the edit, so the cost of an edit does not depend on the length of the
+// recording.
+class PoincareDensity
+{
+public:
+    PoincareDensity();
+
+    void reset(const QVector<double> &peaks); // Peak positions in seconds
+    void update(const QVector<double> &peaks, const PeakEdit &edit); // Peaks after the edit, used if the sums missed an edit
+    void clear();
+
+    bool isEmpty() const;
+    int pairCount() const;
+    double sd1() const; // In ms
+    double sd2() const; // In ms
+
+    // Grid of count(column, row), intervals of the columns on x, the next ones on y
+    int getBins() const;
+    double getLower() const; // In ms
+    double getUpper() const; // In ms
+    int count(int column, int row) const;
+    int maxCount() const;
+
+private:
+    void accumulate(const QVector<double> &beats, int first, int last, int sign); // Pairs of the intervals ending at beats (first, last]
+    int bin(double interval) const; // -1 outside the grid
+
+    QVector<int> counts;
+
+    // Pairs are summed relative to the first interval of the last reset
+    double shift;
+
+    int pairs;
+    double sumX;
+    double sumY;
+    double sumXX;
+    double sumYY;
+    double sumXY;
+};
+
+#endif // POINCAREDENSITY_H
@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2014-2015 Daniel Gromer
+ *
+ * This file is part of PeakMan.
+ *
+ * PeakMan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * PeakMan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PeakMan.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "poincareplot.h"
+
+PoincarePlot::PoincarePlot(QWidget *parent) : QCustomPlot(parent)
+{
+    map = new QCPColorMap(xAxis, yAxis);
+    addPlottable(map);
+    map->setInterpolate(false);
+
+    // Empty bins stay white
+    QCPColorGradient gradient;
+    gradient.setColorStopAt(0, Qt::white);
+    gradient.setColorStopAt(0.01, QColor(198, 219, 239));
+    gradient.setColorStopAt(0.5, QColor(66, 113, 174));
+    gradient.setColorStopAt(1, QColor(200, 40, 41));
+    map->setGradient(gradient);
+
+    identity = new QCPItemStraightLine(this);
+    addItem(identity);
+    identity->point1->setCoords(0, 0);
+    identity->point2->setCoords(1, 1);
+    identity->setPen(QPen(QColor(77, 77, 76), 1, Qt::DashLine));
+
+    // Set axis labels
+    xAxis->setLabel("IBI n (ms)");
+    yAxis->setLabel("IBI n+1 (ms)");
+
+    setInteractions(QCP::iRangeDrag | QCP::iRangeZoom);
+
+    // Appereance of axis grid
+    xAxis->grid()->setPen(QPen(QColor(200, 200, 200), 1, Qt::DotLine));
+    yAxis->grid()->setPen(QPen(QColor(200, 200, 200), 1, Qt::DotLine));
+    xAxis->grid()->setLayer("overlay");
+    yAxis->grid()->setLayer("overlay");
+
+    xAxis->setRange(400, 1400);
+    yAxis->setRange(400, 1400);
+
+    replot();
+}
+
+PoincarePlot::~PoincarePlot()
+{
+
+}
+
+void PoincarePlot::plot(const PoincareDensity &density, bool rescale)
+{
+    int bins = density.getBins();
+    double width = (density.getUpper() - density.getLower()) / bins;
+
+    // Cell coordinates are the bin centers
+    map->data()->setSize(bins, bins);
+    map->data()->setRange(QCPRange(density.getLower() + width / 2, density.getUpper() - width / 2),
+                          QCPRange(density.getLower() + width / 2, density.getUpper() - width / 2));
+
+    // Counts on a log scale, a few outlying pairs still show next to the
+    // dense center
+    int lowest = bins, highest = -1;
+
+    for (int row = 0; row < bins; row++)
+    {
+        for (int column = 0; column < bins; column++)
+        {
+            int count = density.count(column, row);
+
+            map->data()->setCell(column, row, qLn(1.0 + count));
+
+            if (count > 0)
+            {
+                lowest = qMin(lowest, qMin(row, column));
+                highest = qMax(highest, qMax(row, column));
+            }
+        }
+    }
+
+    map->setDataRange(QCPRange(0, qMax(qLn(1.0 + density.maxCount()), 1.0)));
+
+    if (rescale && highest >= 0)
+    {
+        // Same range on both axes, the identity line stays diagonal
+        QCPRange range(density.getLower() + (lowest - 1) * width, density.getLower() + (highest + 2) * width);
+
+        xAxis->setRange(range);
+        yAxis->setRange(range);
+    }
+
+    replot();
+}
+
+void PoincarePlot::clear()
+{
+    map->data()->fill(0);
+
+    replot();
+}
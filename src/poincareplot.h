@@ -0,0 +1,44 @@
+/*
+ * Copyright (C) 2014-2015 Daniel Gromer
+ *
+ * This file is part of PeakMan.
+ *
+ * PeakMan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * PeakMan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PeakMan.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef POINCAREPLOT_H
+#define POINCAREPLOT_H
+
+#include "qcustomplot.h"
+#include "poincaredensity.h"
+
+// Poincaré plot as a color map of the binned interval pairs, one image
+// instead of a scatter point per pair
+class PoincarePlot : public QCustomPlot
+{
+    Q_OBJECT
+
+public:
+    explicit PoincarePlot(QWidget *parent);
+    ~PoincarePlot();
+
+    void plot(const PoincareDensity &density, bool rescale); // Rescale zooms to the occupied bins
+    void clear();
+
+private:
+    QCPColorMap *map;
+    QCPItemStraightLine *identity;
+};
+
+#endif // POINCAREPLOT_H
@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2014-2015 Daniel Gromer
+ *
+ * This file is part of PeakMan.
+ *
+ * PeakMan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * PeakMan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PeakMan.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "polarity.h"
+#include <qmath.h>
+
+// Segments read from the recording, and their length in seconds
+static const int Segments = 20;
+static const double SegmentLength = 10;
+
+// Skewness below this counts as inverted. Biphasic QRS complexes give values
+// around zero, those are left alone.
+static const double InvertedSkewness = -0.3;
+
+// Band-pass of the samples in place, as the difference of two moving
+// averages: the short one (~25 ms) removes noise, the long one (~150 ms)
+// removes baseline wander and the slower P and T waves
+static void bandPass(QVector<double> &x, double sampleRate)
+{
+    int n = x.size();
+    int shortWindow = qMax(1, qRound(0.025 * sampleRate));
+    int longWindow = qMax(shortWindow + 1, qRound(0.15 * sampleRate));
+
+    if (n < longWindow) return;
+
+    // Prefix sums, y[i] compares the averages of windows centered on i
+    QVector<double> sum(n + 1, 0);
+
+    for (int i = 0; i < n; i++)
+    {
+        sum[i + 1] = sum[i] + x[i];
+    }
+
+    QVector<double> y(n, 0);
+
+    for (int i = longWindow / 2; i + longWindow / 2 < n; i++)
+    {
+        int a = i - shortWindow / 2;
+        int b = i - longWindow / 2;
+
+        double shortMean = (sum[a + shortWindow] - sum[a]) / shortWindow;
+        double longMean = (sum[b + longWindow] - sum[b]) / longWindow;
+
+        y[i] = shortMean - longMean;
+    }
+
+    x = y;
+}
+
+double Polarity::skewness(const ECGSignal &signal, double sampleRate)
+{
+    int length = qMax(1, qRound(SegmentLength * sampleRate));
+    int segments = qMin(Segments, qMax(1, signal.size() / length));
+    length = qMin(length, signal.size());
+
+    if (length == 0 || sampleRate <= 0) return 0;
+
+    // Power sums of all segments, the band-passed samples have a mean close
+    // to zero, so the central moments can be taken from them in one pass
+    double n = 0, s1 = 0, s2 = 0, s3 = 0;
+
+    QVector<double> x;
+
+    for (int s = 0; s < segments; s++)
+    {
+        // Spread evenly over the recording
+        int start = (int) ((qint64) (signal.size() - length) * s / qMax(1, segments - 1));
+
+        x.resize(length);
+        signal.read(start, length, x.data());
+        bandPass(x, sampleRate);
+
+        for (int i = 0; i < x.size(); i++)
+        {
+            double v = x[i];
+
+            n++;
+            s1 += v;
+            s2 += v * v;
+            s3 += v * v * v;
+        }
+    }
+
+    double mean = s1 / n;
+    double m2 = s2 / n - mean * mean;
+    double m3 = s3 / n - 3 * mean * s2 / n + 2 * mean * mean * mean;
+
+    if (m2 <= 0) return 0;
+
+    return m3 / qPow(m2, 1.5);
+}
+
+bool Polarity::isInverted(const ECGSignal &signal, double sampleRate)
+{
+    return skewness(signal, sampleRate) < InvertedSkewness;
+}
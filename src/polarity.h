@@ -0,0 +1,36 @@
+/*
+ * Copyright (C) 2014-2015 Daniel Gromer
+ *
+ * This file is part of PeakMan.
+ *
+ * PeakMan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * PeakMan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PeakMan.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef POLARITY_H
+#define POLARITY_H
+
+#include "ecgsignal.h"
+
+// Polarity check for ecg signals with inverted leads. R waves are the largest
+// deflections of a band-passed ecg, so its skewness is positive for a
+// correctly connected lead and negative for an inverted one. Only a sample of
+// segments spread over the recording is read.
+class Polarity
+{
+public:
+    static double skewness(const ECGSignal &signal, double sampleRate);
+    static bool isInverted(const ECGSignal &signal, double sampleRate);
+};
+
+#endif // POLARITY_H
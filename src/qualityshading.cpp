@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2014-2015 Daniel Gromer
+ *
+ * This file is part of PeakMan.
+ *
+ * PeakMan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * PeakMan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PeakMan.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "qualityshading.h"
+
+QualityShading::QualityShading(QCPAxis *keyAxis, QCPAxis *valueAxis) : QCPAbstractPlottable(keyAxis, valueAxis)
+{
+    unusable = 0;
+    segmentDuration = 0;
+
+    setSelectable(false);
+}
+
+QualityShading::~QualityShading()
+{
+
+}
+
+void QualityShading::setSegments(const QVector<bool> *unusable, double segmentDuration)
+{
+    this->unusable = unusable;
+    this->segmentDuration = segmentDuration;
+}
+
+void QualityShading::clearData()
+{
+    unusable = 0;
+}
+
+double QualityShading::selectTest(const QPointF &pos, bool onlySelectable, QVariant *details) const
+{
+    Q_UNUSED(pos)
+    Q_UNUSED(onlySelectable)
+    Q_UNUSED(details)
+
+    return -1;
+}
+
+void QualityShading::draw(QCPPainter *painter)
+{
+    if (!unusable || unusable->isEmpty() || segmentDuration <= 0 || !mKeyAxis) return;
+
+    QCPRange range = mKeyAxis.data()->range();
+    QRect rect = clipRect();
+
+    int first = qMax(0, (int) (range.lower / segmentDuration));
+    int last = qMin(unusable->size(), (int) (range.upper / segmentDuration) + 1);
+
+    painter->setPen(Qt::NoPen);
+    painter->setBrush(mBrush);
+
+    for (int i = first; i < last; i++)
+    {
+        if (!unusable->at(i)) continue;
+
+        int end = i + 1;
+
+        while (end < last && unusable->at(end)) end++;
+
+        double left = mKeyAxis.data()->coordToPixel(i * segmentDuration);
+        double right = mKeyAxis.data()->coordToPixel(end * segmentDuration);
+
+        painter->drawRect(QRectF(QPointF(left, rect.top()), QPointF(right, rect.bottom())));
+
+        i = end;
+    }
+}
+
+void QualityShading::drawLegendIcon(QCPPainter *painter, const QRectF &rect) const
+{
+    painter->setPen(Qt::NoPen);
+    painter->setBrush(mBrush);
+    painter->drawRect(rect);
+}
+
+QCPRange QualityShading::getKeyRange(bool &foundRange, SignDomain inSignDomain) const
+{
+    Q_UNUSED(inSignDomain)
+
+    foundRange = unusable && !unusable->isEmpty();
+
+    return foundRange ? QCPRange(0, unusable->size() * segmentDuration) : QCPRange();
+}
+
+QCPRange QualityShading::getValueRange(bool &foundRange, SignDomain inSignDomain) const
+{
+    Q_UNUSED(inSignDomain)
+
+    // Shading spans the whole value axis
+    foundRange = false;
+
+    return QCPRange();
+}
@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2014-2015 Daniel Gromer
+ *
+ * This file is part of PeakMan.
+ *
+ * PeakMan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * PeakMan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PeakMan.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QUALITYSHADING_H
+#define QUALITYSHADING_H
+
+#include "qcustomplot.h"
+
+// Plottable that shades unusable segments of an ecg signal over the full
+// height of the axis rect. Adjacent unusable segments are drawn as one block.
+class QualityShading : public QCPAbstractPlottable
+{
+    Q_OBJECT
+
+public:
+    explicit QualityShading(QCPAxis *keyAxis, QCPAxis *valueAxis);
+    ~QualityShading();
+
+    // One flag per segment, true if the segment is unusable
+    void setSegments(const QVector<bool> *unusable, double segmentDuration);
+
+    virtual void clearData();
+    virtual double selectTest(const QPointF &pos, bool onlySelectable, QVariant *details = 0) const;
+
+protected:
+    virtual void draw(QCPPainter *painter);
+    virtual void drawLegendIcon(QCPPainter *painter, const QRectF &rect) const;
+    virtual QCPRange getKeyRange(bool &foundRange, SignDomain inSignDomain = sdBoth) const;
+    virtual QCPRange getValueRange(bool &foundRange, SignDomain inSignDomain = sdBoth) const;
+
+private:
+    const QVector<bool> *unusable;
+    double segmentDuration;
+};
+
+#endif // QUALITYSHADING_H
@@ -0,0 +1,243 @@
+/*
+ * Copyright (C) 2014-2015 Daniel Gromer
+ *
+ * This file is part of PeakMan.
+ *
+ * PeakMan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * PeakMan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PeakMan.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "resampler.h"
+#include <QThread>
+#include <QtConcurrentMap>
+#include <qmath.h>
+
+// Output samples per block, blocks are resampled in parallel
+static const int ChunkSize = 65536;
+
+// Zero crossings of the sinc on each side of the center, at the lower of the
+// two rates. Together with the Kaiser window this keeps aliasing below -80 dB.
+static const int ZeroCrossings = 16;
+static const double KaiserBeta = 8.6;
+
+// Passband edge relative to the lower Nyquist frequency
+static const double Rolloff = 0.9;
+
+struct ResampleChunk
+{
+    const ECGSignal *signal;
+    const QVector<double> *bank;
+    int up;
+    int down;
+    int halfTaps;
+    qint64 start; // First output sample
+    int count;
+    QVector<double> output;
+};
+
+// Zeroth order modified Bessel function of the first kind, for the Kaiser window
+static double besselI0(double x)
+{
+    double sum = 1;
+    double term = 1;
+
+    for (int k = 1; k < 50; k++)
+    {
+        term *= (x / (2 * k)) * (x / (2 * k));
+        sum += term;
+
+        if (term < 1e-12 * sum) break;
+    }
+
+    return sum;
+}
+
+static void resampleChunk(ResampleChunk &chunk)
+{
+    int n = chunk.signal->size();
+    int taps = 2 * chunk.halfTaps + 1;
+
+    // Input samples needed by this block, the signal is held constant beyond
+    // its ends
+    qint64 last = chunk.start + chunk.count - 1;
+    int from = (int) (chunk.start * chunk.down / chunk.up) - chunk.halfTaps;
+    int to = (int) (last * chunk.down / chunk.up) + chunk.halfTaps + 1;
+
+    QVector<double> input(to - from);
+    int first = qMax(from, 0);
+    int end = qMin(to, n);
+
+    if (end > first)
+    {
+        chunk.signal->read(first, end - first, input.data() + (first - from));
+    }
+
+    for (int i = from; i < first; i++) input[i - from] = chunk.signal->at(0);
+    for (int i = qMax(end, from); i < to; i++) input[i - from] = chunk.signal->at(n - 1);
+
+    chunk.output.resize(chunk.count);
+
+    for (int i = 0; i < chunk.count; i++)
+    {
+        qint64 t = (chunk.start + i) * chunk.down;
+        int center = (int) (t / chunk.up);
+        int phase = (int) (t % chunk.up);
+
+        const double *h = chunk.bank->constData() + phase * taps;
+        const double *x = input.constData() + (center - from) + chunk.halfTaps;
+
+        // Tap k weights input sample center - (k - halfTaps)
+        double y = 0;
+
+        for (int k = 0; k < taps; k++)
+        {
+            y += h[k] * x[-k];
+        }
+
+        chunk.output[i] = y;
+    }
+}
+
+Resampler::Resampler(int sourceRate, int targetRate)
+{
+    this->sourceRate = qMax(1, sourceRate);
+    this->targetRate = qMax(1, targetRate);
+
+    // Reduce the ratio, this keeps the filter bank small for common pairs
+    // like 1024 -> 1000 Hz (125 phases)
+    int a = this->sourceRate;
+    int b = this->targetRate;
+
+    while (b != 0)
+    {
+        int r = a % b;
+        a = b;
+        b = r;
+    }
+
+    up = this->targetRate / a;
+    down = this->sourceRate / a;
+
+    design();
+}
+
+int Resampler::getSourceRate() const
+{
+    return sourceRate;
+}
+
+int Resampler::getTargetRate() const
+{
+    return targetRate;
+}
+
+bool Resampler::isIdentity() const
+{
+    return up == down;
+}
+
+int Resampler::outputSize(int inputSize) const
+{
+    return (int) (((qint64) inputSize * up + down - 1) / down);
+}
+
+ECGSignal Resampler::apply(const ECGSignal &signal) const
+{
+    if (signal.isEmpty() || isIdentity()) return signal;
+
+    ECGSignal resampled;
+
+    qint64 n = outputSize(signal.size());
+    qint64 chunks = (n + ChunkSize - 1) / ChunkSize;
+    int batchSize = 2 * qMax(1, QThread::idealThreadCount());
+
+    for (qint64 firstChunk = 0; firstChunk < chunks; firstChunk += batchSize)
+    {
+        QVector<ResampleChunk> batch;
+
+        for (qint64 c = firstChunk; c < qMin(chunks, firstChunk + batchSize); c++)
+        {
+            ResampleChunk chunk;
+            chunk.signal = &signal;
+            chunk.bank = &bank;
+            chunk.up = up;
+            chunk.down = down;
+            chunk.halfTaps = halfTaps;
+            chunk.start = c * ChunkSize;
+            chunk.count = (int) qMin((qint64) ChunkSize, n - chunk.start);
+
+            batch << chunk;
+        }
+
+        QtConcurrent::blockingMap(batch, resampleChunk);
+
+        for (int c = 0; c < batch.size(); c++)
+        {
+            for (int i = 0; i < batch[c].count; i++)
+            {
+                resampled.append(batch[c].output[i]);
+            }
+
+            batch[c].output.clear();
+        }
+    }
+
+    resampled.squeeze();
+
+    return resampled;
+}
+
+void Resampler::design()
+{
+    // Prototype low-pass at the upsampled rate (source rate * up), cut off at
+    // the lower of the two Nyquist frequencies. Downsampling widens the
+    // filter in input samples by down / up.
+    double cutoff = Rolloff * 0.5 / qMax(up, down); // Cycles per upsampled sample
+    double halfWidth = ZeroCrossings * qMax(up, down); // In upsampled samples
+
+    halfTaps = qCeil(halfWidth / up);
+
+    int taps = 2 * halfTaps + 1;
+    bank = QVector<double>(up * taps);
+
+    for (int phase = 0; phase < up; phase++)
+    {
+        double *h = bank.data() + phase * taps;
+        double sum = 0;
+
+        for (int k = 0; k < taps; k++)
+        {
+            // Distance of the tap from the filter center, in upsampled samples
+            double u = phase + (k - halfTaps) * (double) up;
+            double value = 0;
+
+            if (qAbs(u) < halfWidth)
+            {
+                double x = 2 * cutoff * u;
+                double sinc = x == 0 ? 1 : qSin(M_PI * x) / (M_PI * x);
+                double r = u / halfWidth;
+
+                value = 2 * cutoff * sinc * besselI0(KaiserBeta * qSqrt(1 - r * r)) / besselI0(KaiserBeta);
+            }
+
+            h[k] = value;
+            sum += value;
+        }
+
+        // Unity gain at DC for every phase, so a constant signal stays constant
+        for (int k = 0; k < taps; k++)
+        {
+            h[k] /= sum;
+        }
+    }
+}
@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2014-2015 Daniel Gromer
+ *
+ * This file is part of PeakMan.
+ *
+ * PeakMan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * PeakMan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PeakMan.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RESAMPLER_H
+#define RESAMPLER_H
+
+#include <QVector>
+#include "ecgsignal.h"
+
+// Rational polyphase resampler for converting ecg signals between sample
+// rates. The windowed-sinc anti-aliasing filter is split into one short filter
+// per output phase when the resampler is created, so each output sample costs
+// a single dot product. Signals are converted in parallel blocks of output
+// samples, reading only the input samples each block needs.
+class Resampler
+{
+public:
+    Resampler(int sourceRate, int targetRate);
+
+    int getSourceRate() const;
+    int getTargetRate() const;
+    bool isIdentity() const;
+
+    int outputSize(int inputSize) const;
+    ECGSignal apply(const ECGSignal &signal) const;
+
+private:
+    void design();
+
+    int sourceRate;
+    int targetRate;
+    int up; // Target rate = source rate * up / down
+    int down;
+    int halfTaps; // Taps on each side of the center of a phase filter
+
+    QVector<double> bank; // Phase filters, bank[phase * (2 * halfTaps + 1) + tap]
+};
+
+#endif // RESAMPLER_H
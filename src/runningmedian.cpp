@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2014-2015 Daniel Gromer
+ *
+ * This file is part of PeakMan.
+ *
+ * PeakMan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * PeakMan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PeakMan.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "runningmedian.h"
+
+RunningMedian::RunningMedian()
+{
+
+}
+
+void RunningMedian::insert(double value)
+{
+    if (lower.empty() || value <= *lower.rbegin())
+    {
+        lower.insert(value);
+    }
+    else
+    {
+        upper.insert(value);
+    }
+
+    rebalance();
+}
+
+void RunningMedian::remove(double value)
+{
+    std::multiset<double>::iterator iter = lower.find(value);
+
+    if (iter != lower.end())
+    {
+        lower.erase(iter);
+    }
+    else
+    {
+        iter = upper.find(value);
+
+        if (iter != upper.end()) upper.erase(iter);
+    }
+
+    rebalance();
+}
+
+void RunningMedian::clear()
+{
+    lower.clear();
+    upper.clear();
+}
+
+double RunningMedian::median() const
+{
+    if (lower.empty()) return 0;
+
+    // Mean of both middle values for an even number of values
+    if (lower.size() == upper.size())
+    {
+        return (*lower.rbegin() + *upper.begin()) / 2;
+    }
+
+    return *lower.rbegin();
+}
+
+int RunningMedian::size() const
+{
+    return (int) (lower.size() + upper.size());
+}
+
+void RunningMedian::rebalance()
+{
+    // Lower half has as many values as the upper half, or one more
+    if (lower.size() > upper.size() + 1)
+    {
+        std::multiset<double>::iterator iter = --lower.end();
+        upper.insert(*iter);
+        lower.erase(iter);
+    }
+    else if (upper.size() > lower.size())
+    {
+        lower.insert(*upper.begin());
+        upper.erase(upper.begin());
+    }
+}
@@ -0,0 +1,46 @@
+/*
+ * Copyright (C) 2014-2015 Daniel Gromer
+ *
+ * This file is part of PeakMan.
+ *
+ * PeakMan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * PeakMan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PeakMan.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RUNNINGMEDIAN_H
+#define RUNNINGMEDIAN_H
+
+#include <set>
+
+// Median of a sliding window. Values are kept in two balanced multisets (lower
+// and upper half), so inserting and removing a value is O(log w).
+class RunningMedian
+{
+public:
+    RunningMedian();
+
+    void insert(double value);
+    void remove(double value); // Value must be in the window
+    void clear();
+
+    double median() const;
+    int size() const;
+
+private:
+    void rebalance();
+
+    std::multiset<double> lower; // Largest value of the lower half is the median
+    std::multiset<double> upper;
+};
+
+#endif // RUNNINGMEDIAN_H
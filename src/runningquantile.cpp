@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2014-2015 Daniel Gromer
+ *
+ * This file is part of PeakMan.
+ *
+ * PeakMan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * PeakMan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PeakMan.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "runningquantile.h"
+
+RunningQuantile::RunningQuantile(double fraction) : fraction(fraction)
+{
+
+}
+
+void RunningQuantile::insert(double value)
+{
+    if (lower.empty() || value <= *lower.rbegin())
+    {
+        lower.insert(value);
+    }
+    else
+    {
+        upper.insert(value);
+    }
+
+    rebalance();
+}
+
+void RunningQuantile::remove(double value)
+{
+    std::multiset<double>::iterator iter = lower.find(value);
+
+    if (iter != lower.end())
+    {
+        lower.erase(iter);
+    }
+    else
+    {
+        iter = upper.find(value);
+
+        if (iter != upper.end()) upper.erase(iter);
+    }
+
+    rebalance();
+}
+
+void RunningQuantile::clear()
+{
+    lower.clear();
+    upper.clear();
+}
+
+double RunningQuantile::quantile() const
+{
+    if (lower.empty()) return 0;
+
+    return *lower.rbegin();
+}
+
+int RunningQuantile::size() const
+{
+    return (int) (lower.size() + upper.size());
+}
+
+void RunningQuantile::rebalance()
+{
+    // Lower part holds the first fraction of the values, at least one
+    int n = size();
+    int wanted = n > 0 ? (int) (fraction * (n - 1)) + 1 : 0;
+
+    while ((int) lower.size() > wanted)
+    {
+        std::multiset<double>::iterator iter = --lower.end();
+        upper.insert(*iter);
+        lower.erase(iter);
+    }
+
+    while ((int) lower.size() < wanted)
+    {
+        lower.insert(*upper.begin());
+        upper.erase(upper.begin());
+    }
+}
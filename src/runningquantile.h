@@ -0,0 +1,47 @@
+/*
+ * Copyright (C) 2014-2015 Daniel Gromer
+ *
+ * This file is part of PeakMan.
+ *
+ * PeakMan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * PeakMan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PeakMan.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RUNNINGQUANTILE_H
+#define RUNNINGQUANTILE_H
+
+#include <set>
+
+// Quantile of a sliding window, like RunningMedian but with the split between
+// the two multisets at any fraction. Inserting and removing a value is O(log w).
+class RunningQuantile
+{
+public:
+    explicit RunningQuantile(double fraction); // 0.25 for the first quartile
+
+    void insert(double value);
+    void remove(double value); // Value must be in the window
+    void clear();
+
+    double quantile() const; // Smallest value with at least the fraction of values below or equal
+    int size() const;
+
+private:
+    void rebalance();
+
+    double fraction;
+    std::multiset<double> lower; // Largest value of the lower part is the quantile
+    std::multiset<double> upper;
+};
+
+#endif // RUNNINGQUANTILE_H
@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2014-2015 Daniel Gromer
+ *
+ * This file is part of PeakMan.
+ *
+ * PeakMan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * PeakMan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PeakMan.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "sessionqueue.h"
+#include "datafile.h"
+#include "resampler.h"
+#include "ecgsignal.h"
+#include <QtConcurrentRun>
+
+// Memory all preloaded sessions together may keep resident (1 GB)
+static const qint64 PreloadBudget = (qint64) 1024 * 1048576;
+
+SessionQueue::SessionQueue(QObject *parent) : QObject(parent)
+{
+}
+
+SessionQueue::~SessionQueue()
+{
+    clear();
+}
+
+void SessionQueue::enqueue(QString ecgFileName, QString peaksFileName, int sampleRate, int targetSampleRate)
+{
+    Session session;
+    session.ecgFileName = ecgFileName;
+    session.peaksFileName = peaksFileName;
+    session.sampleRate = sampleRate;
+    session.targetSampleRate = targetSampleRate;
+
+    pending << session;
+
+    startLoading();
+}
+
+Session SessionQueue::takeNext()
+{
+    if (loading.isEmpty()) startLoading();
+    if (loading.isEmpty()) return Session();
+
+    // Blocks only if the session is not loaded yet
+    Session session = loading.takeFirst().result();
+
+    startLoading();
+
+    return session;
+}
+
+void SessionQueue::clear()
+{
+    pending.clear();
+
+    // Running loads can't be cancelled, wait for them before dropping them
+    for (int i = 0; i < loading.size(); i++)
+    {
+        loading[i].waitForFinished();
+    }
+
+    loading.clear();
+}
+
+bool SessionQueue::isEmpty() const
+{
+    return size() == 0;
+}
+
+int SessionQueue::size() const
+{
+    return pending.size() + loading.size();
+}
+
+Session SessionQueue::load(Session session)
+{
+    session.signal = DataFile::readSignal(session.ecgFileName);
+
+    if (session.targetSampleRate > 0 && session.targetSampleRate != session.sampleRate)
+    {
+        Resampler resampler(session.sampleRate, session.targetSampleRate);
+        session.signal = resampler.apply(session.signal);
+    }
+
+    if (!session.peaksFileName.isEmpty())
+    {
+        session.peaks = DataFile::readValues(session.peaksFileName);
+    }
+
+    return session;
+}
+
+void SessionQueue::startLoading()
+{
+    // Number of sessions loaded ahead. Each of them keeps up to the memory
+    // limit of ECGSignal resident before it spills to a swap file, so only
+    // one or two sessions are loaded ahead. Taken here so that a limit set
+    // after the queue was created applies.
+    int preload = (int) qBound((qint64) 1, PreloadBudget / qMax((qint64) 1, ECGSignal::memoryLimit()), (qint64) 2);
+
+    while (!pending.isEmpty() && loading.size() < preload)
+    {
+        loading << QtConcurrent::run(&SessionQueue::load, pending.takeFirst());
+    }
+}
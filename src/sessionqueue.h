@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2014-2015 Daniel Gromer
+ *
+ * This file is part of PeakMan.
+ *
+ * PeakMan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * PeakMan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PeakMan.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SESSIONQUEUE_H
+#define SESSIONQUEUE_H
+
+#include <QObject>
+#include <QFuture>
+#include <QList>
+#include "ecgsignal.h"
+
+// A recording (and optionally its peaks) to be reviewed
+struct Session
+{
+    Session() : sampleRate(0), targetSampleRate(0) {}
+
+    QString ecgFileName;
+    QString peaksFileName;
+    int sampleRate; // Of the file
+    int targetSampleRate; // Signal is resampled to this rate while loading, 0 keeps the file's rate
+
+    ECGSignal signal;
+    QVector<double> peaks;
+};
+
+// Queue of recordings for a review session. Recordings are parsed ahead of
+// time on the global thread pool, so opening the next one is instant.
+class SessionQueue : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit SessionQueue(QObject *parent = 0);
+    ~SessionQueue();
+
+    void enqueue(QString ecgFileName, QString peaksFileName, int sampleRate, int targetSampleRate = 0);
+    Session takeNext(); // Waits if the next session is still loading
+    void clear();
+
+    bool isEmpty() const;
+    int size() const;
+
+private:
+    static Session load(Session session);
+    void startLoading();
+
+    QList<Session> pending; // Not started yet
+    QList<QFuture<Session> > loading; // Loading or loaded, in queue order
+};
+
+#endif // SESSIONQUEUE_H
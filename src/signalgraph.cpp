@@ -0,0 +1,182 @@
+/*
+ * Copyright (C) 2014-2015 Daniel Gromer
+ *
+ * This file is part of PeakMan.
+ *
+ * PeakMan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * PeakMan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PeakMan.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "signalgraph.h"
+
+SignalGraph::SignalGraph(QCPAxis *keyAxis, QCPAxis *valueAxis) : QCPAbstractPlottable(keyAxis, valueAxis)
+{
+    signal = 0;
+    sampleRate = 1;
+
+    setSelectable(false);
+}
+
+SignalGraph::~SignalGraph()
+{
+
+}
+
+void SignalGraph::setSignal(const ECGSignal *signal, double sampleRate)
+{
+    this->signal = signal;
+    this->sampleRate = sampleRate > 0 ? sampleRate : 1;
+}
+
+void SignalGraph::clearData()
+{
+    signal = 0;
+}
+
+double SignalGraph::selectTest(const QPointF &pos, bool onlySelectable, QVariant *details) const
+{
+    Q_UNUSED(pos)
+    Q_UNUSED(onlySelectable)
+    Q_UNUSED(details)
+
+    // The signal itself is never selectable
+    return -1;
+}
+
+void SignalGraph::draw(QCPPainter *painter)
+{
+    if (!signal || signal->isEmpty() || !mKeyAxis || !mValueAxis) return;
+
+    QCPRange range = mKeyAxis.data()->range();
+
+    // Samples inside the visible range, plus one on each side
+    int first = qMax(0, qFloor(range.lower * sampleRate) - 1);
+    int last = qMin(signal->size() - 1, qCeil(range.upper * sampleRate) + 1);
+
+    if (last <= first) return;
+
+    int count = last - first + 1;
+    int pixels = qMax(1, qRound(qAbs(mKeyAxis.data()->coordToPixel(range.upper) - mKeyAxis.data()->coordToPixel(range.lower))));
+
+    const int blockSize = 4096;
+    QVector<double> block(blockSize);
+    QVector<QPointF> lineData;
+
+    if (count <= 2 * pixels)
+    {
+        // Few samples in view, draw every single one
+        lineData.reserve(count);
+
+        for (int from = first; from <= last; from += blockSize)
+        {
+            int n = qMin(blockSize, last - from + 1);
+            signal->read(from, n, block.data());
+
+            for (int i = 0; i < n; i++)
+            {
+                lineData << coordsToPixels((from + i) / sampleRate, block[i]);
+            }
+        }
+    }
+    else if (count >= 4 * pixels * ECGSignal::SummarySize)
+    {
+        // Far zoomed out, use the min/max summary instead of touching every
+        // sample (which might have to be paged in from a swap file)
+        lineData.reserve(2 * pixels);
+
+        int firstBucket = first / ECGSignal::SummarySize;
+        int lastBucket = last / ECGSignal::SummarySize;
+        double bucketsPerPixel = (double) (lastBucket - firstBucket + 1) / pixels;
+
+        for (int column = 0; column < pixels; column++)
+        {
+            int from = firstBucket + (int) (column * bucketsPerPixel);
+            int to = qMin(lastBucket, firstBucket + (int) ((column + 1) * bucketsPerPixel) - 1);
+            double mn = signal->summaryMinimum(from), mx = signal->summaryMaximum(from);
+
+            for (int b = from + 1; b <= to; b++)
+            {
+                mn = qMin(mn, signal->summaryMinimum(b));
+                mx = qMax(mx, signal->summaryMaximum(b));
+            }
+
+            double key = (double) from * ECGSignal::SummarySize / sampleRate;
+            lineData << coordsToPixels(key, mn) << coordsToPixels(key, mx);
+        }
+    }
+    else
+    {
+        // More samples than pixels, draw min and max of each pixel column
+        lineData.reserve(2 * pixels);
+
+        double samplesPerPixel = (double) count / pixels;
+        int column = 0;
+        int columnEnd = first + qMax(1, (int) samplesPerPixel);
+        double mn = signal->at(first), mx = mn;
+
+        for (int from = first; from <= last; from += blockSize)
+        {
+            int n = qMin(blockSize, last - from + 1);
+            signal->read(from, n, block.data());
+
+            for (int i = 0; i < n; i++)
+            {
+                if (from + i >= columnEnd)
+                {
+                    double key = (columnEnd - 1) / sampleRate;
+                    lineData << coordsToPixels(key, mn) << coordsToPixels(key, mx);
+
+                    column++;
+                    columnEnd = first + qMax(column + 1, (int) ((column + 1) * samplesPerPixel));
+                    mn = block[i];
+                    mx = block[i];
+                }
+
+                mn = qMin(mn, block[i]);
+                mx = qMax(mx, block[i]);
+            }
+        }
+
+        lineData << coordsToPixels(last / sampleRate, mn) << coordsToPixels(last / sampleRate, mx);
+    }
+
+    applyDefaultAntialiasingHint(painter);
+    painter->setPen(mainPen());
+    painter->setBrush(Qt::NoBrush);
+    painter->drawPolyline(lineData.constData(), lineData.size());
+}
+
+void SignalGraph::drawLegendIcon(QCPPainter *painter, const QRectF &rect) const
+{
+    applyDefaultAntialiasingHint(painter);
+    painter->setPen(mPen);
+    painter->drawLine(QLineF(rect.left(), rect.top() + rect.height() / 2.0, rect.right(), rect.top() + rect.height() / 2.0));
+}
+
+QCPRange SignalGraph::getKeyRange(bool &foundRange, SignDomain inSignDomain) const
+{
+    Q_UNUSED(inSignDomain)
+
+    foundRange = signal && !signal->isEmpty();
+
+    return foundRange ? QCPRange(0, (signal->size() - 1) / sampleRate) : QCPRange();
+}
+
+QCPRange SignalGraph::getValueRange(bool &foundRange, SignDomain inSignDomain) const
+{
+    Q_UNUSED(inSignDomain)
+
+    foundRange = signal && !signal->isEmpty();
+
+    return foundRange ? QCPRange(signal->minimum(), signal->maximum()) : QCPRange();
+}
@@ -0,0 +1,249 @@
+/*
+ * Copyright (C) 2014-2015 Daniel Gromer
+ *
+ * This file is part of PeakMan.
+ *
+ * PeakMan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * PeakMan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PeakMan.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "signalquality.h"
+#include "fft.h"
+#include <QtConcurrentMap>
+#include <qmath.h>
+#include <algorithm>
+
+// Feature ranges of usable segments
+static const double MinKurtosis = 5;
+static const double MinSpectralRatio = 0.5;
+static const double MaxSpectralRatio = 0.9;
+static const double MinAgreement = 0.8;
+
+// Beats of both detectors closer than this (seconds) are the same beat
+static const double MatchTolerance = 0.15;
+
+// Shortest interval between two beats (seconds)
+static const double Refractory = 0.25;
+
+struct QualityTask
+{
+    ECGSignal signal; // Shared, copies of an ECGSignal are cheap
+    double sampleRate;
+    int start;
+    int count;
+};
+
+static double percentile(QVector<double> values, double p)
+{
+    if (values.isEmpty()) return 0;
+
+    int k = qMin(values.size() - 1, (int) (p * values.size()));
+    std::nth_element(values.begin(), values.begin() + k, values.end());
+
+    return values[k];
+}
+
+// Local maxima of x above threshold, at least refractory samples apart
+static QVector<int> localMaxima(const QVector<double> &x, double threshold, int refractory)
+{
+    QVector<int> beats;
+
+    for (int i = 1; i < x.size() - 1; i++)
+    {
+        if (x[i] <= threshold || x[i] < x[i - 1] || x[i] < x[i + 1]) continue;
+
+        if (!beats.isEmpty() && i - beats.last() < refractory)
+        {
+            // Keep the larger one of two close maxima
+            if (x[i] > x[beats.last()]) beats.last() = i;
+        }
+        else
+        {
+            beats << i;
+        }
+    }
+
+    return beats;
+}
+
+// Slope detector: squared derivative integrated over 150 ms
+static QVector<int> slopeBeats(const QVector<double> &x, double sampleRate)
+{
+    int n = x.size();
+    int window = qMax(1, qRound(0.15 * sampleRate));
+
+    QVector<double> energy(n, 0);
+
+    for (int i = 1; i < n - 1; i++)
+    {
+        double d = x[i + 1] - x[i - 1];
+        energy[i] = d * d;
+    }
+
+    QVector<double> integrated(n, 0);
+    double sum = 0;
+
+    for (int i = 0; i < n; i++)
+    {
+        sum += energy[i];
+
+        if (i >= window) sum -= energy[i - window];
+
+        // Centered on the window, so beats line up with the amplitude detector
+        integrated[qMax(0, i - window / 2)] = sum / window;
+    }
+
+    return localMaxima(integrated, 0.3 * percentile(integrated, 0.98), qRound(Refractory * sampleRate));
+}
+
+// Amplitude detector: absolute deviation from the median of the segment
+static QVector<int> amplitudeBeats(const QVector<double> &x, double sampleRate)
+{
+    double median = percentile(x, 0.5);
+
+    QVector<double> deviation(x.size());
+
+    for (int i = 0; i < x.size(); i++)
+    {
+        deviation[i] = qAbs(x[i] - median);
+    }
+
+    return localMaxima(deviation, 0.5 * percentile(deviation, 0.99), qRound(Refractory * sampleRate));
+}
+
+static double agreement(const QVector<int> &a, const QVector<int> &b, int tolerance)
+{
+    if (a.isEmpty() || b.isEmpty()) return 0;
+
+    int matched = 0;
+    int i = 0, j = 0;
+
+    while (i < a.size() && j < b.size())
+    {
+        if (qAbs(a[i] - b[j]) <= tolerance)
+        {
+            matched++;
+            i++;
+            j++;
+        }
+        else if (a[i] < b[j])
+        {
+            i++;
+        }
+        else
+        {
+            j++;
+        }
+    }
+
+    return (double) matched / (a.size() + b.size() - matched);
+}
+
+static SignalQuality::Segment assessSegment(const QualityTask &task)
+{
+    SignalQuality::Segment segment;
+    segment.start = task.start;
+    segment.count = task.count;
+
+    QVector<double> x(task.count);
+    task.signal.read(task.start, task.count, x.data());
+
+    // Kurtosis
+    double mean = 0;
+
+    for (int i = 0; i < x.size(); i++) mean += x[i];
+
+    mean /= x.size();
+
+    double m2 = 0, m4 = 0;
+
+    for (int i = 0; i < x.size(); i++)
+    {
+        double d = (x[i] - mean) * (x[i] - mean);
+        m2 += d;
+        m4 += d * d;
+    }
+
+    m2 /= x.size();
+    m4 /= x.size();
+
+    // A flat line has no ecg at all, all features stay at 0
+    if (m2 <= 0) return segment;
+
+    segment.kurtosis = m4 / (m2 * m2);
+
+    // Power ratio of QRS band and ecg band
+    int size = FFT::nextPowerOfTwo(x.size());
+    QVector<double> power = FFT::powerSpectrum(x.constData(), x.size(), size);
+
+    double qrs = 0, ecg = 0;
+
+    for (int k = 0; k < power.size(); k++)
+    {
+        double frequency = k * task.sampleRate / size;
+
+        if (frequency >= 5 && frequency <= 15) qrs += power[k];
+        if (frequency >= 5 && frequency <= 40) ecg += power[k];
+    }
+
+    segment.spectralRatio = ecg > 0 ? qrs / ecg : 0;
+
+    // Detector agreement
+    segment.agreement = agreement(slopeBeats(x, task.sampleRate), amplitudeBeats(x, task.sampleRate),
+                                  qRound(MatchTolerance * task.sampleRate));
+
+    int passed = 0;
+
+    if (segment.kurtosis > MinKurtosis) passed++;
+    if (segment.spectralRatio >= MinSpectralRatio && segment.spectralRatio <= MaxSpectralRatio) passed++;
+    if (segment.agreement >= MinAgreement) passed++;
+
+    segment.usable = passed >= 2;
+
+    return segment;
+}
+
+SignalQuality::SignalQuality()
+{
+    segmentLength = 10;
+}
+
+void SignalQuality::setSegmentLength(double seconds)
+{
+    segmentLength = seconds;
+}
+
+double SignalQuality::getSegmentLength() const
+{
+    return segmentLength;
+}
+
+QFuture<SignalQuality::Segment> SignalQuality::start(const ECGSignal &signal, double sampleRate) const
+{
+    QVector<QualityTask> tasks;
+
+    int length = qMax(1, qRound(segmentLength * sampleRate));
+
+    for (int start = 0; start < signal.size(); start += length)
+    {
+        QualityTask task;
+        task.signal = signal;
+        task.sampleRate = sampleRate;
+        task.start = start;
+        task.count = qMin(length, signal.size() - start);
+
+        tasks << task;
+    }
+
+    return QtConcurrent::mapped(tasks, assessSegment);
+}
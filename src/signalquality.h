@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2014-2015 Daniel Gromer
+ *
+ * This file is part of PeakMan.
+ *
+ * PeakMan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * PeakMan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PeakMan.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SIGNALQUALITY_H
+#define SIGNALQUALITY_H
+
+#include <QVector>
+#include <QFuture>
+#include "ecgsignal.h"
+
+// Signal quality index of fixed-length segments of an ecg signal, from three
+// features:
+//  - kurtosis of the samples, high for a clean ecg with sharp QRS complexes
+//  - QRS power (5-15 Hz) relative to the ecg band (5-40 Hz)
+//  - agreement of two simple beat detectors that fail on different noise
+// A segment is usable if at least two of the features are in range.
+class SignalQuality
+{
+public:
+    struct Segment
+    {
+        Segment() : start(0), count(0), kurtosis(0), spectralRatio(0), agreement(0), usable(false) {}
+
+        int start; // First sample
+        int count;
+        double kurtosis;
+        double spectralRatio;
+        double agreement; // Matched beats / beats found by either detector
+        bool usable;
+    };
+
+    SignalQuality();
+
+    void setSegmentLength(double seconds);
+    double getSegmentLength() const;
+
+    // Assesses all segments in parallel on the global thread pool. Results
+    // arrive in segment order and can be collected with a QFutureWatcher.
+    QFuture<Segment> start(const ECGSignal &signal, double sampleRate) const;
+
+private:
+    double segmentLength;
+};
+
+#endif // SIGNALQUALITY_H
@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2014-2015 Daniel Gromer
+ *
+ * This file is part of PeakMan.
+ *
+ * PeakMan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * PeakMan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PeakMan.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "slidinghrv.h"
+#include <qmath.h>
+#include <QtNumeric>
+
+SlidingHRV::SlidingHRV()
+{
+    window = 300;
+    step = 30;
+}
+
+void SlidingHRV::setWindow(double seconds)
+{
+    window = seconds;
+}
+
+void SlidingHRV::setStep(double seconds)
+{
+    step = seconds;
+}
+
+double SlidingHRV::getWindow() const
+{
+    return window;
+}
+
+SlidingHRV::Result SlidingHRV::compute(const QVector<double> &peaks) const
+{
+    Result result;
+    result.window = window;
+    int n = peaks.size();
+
+    if (n < 3 || window <= 0 || step <= 0) return result;
+
+    // Sums are relative to the first interval, so that the variance doesn't
+    // cancel out over a long series of additions and evictions
+    double shift = peaks[1] - peaks[0];
+
+    int count = 0;
+    double sum = 0, sumSquares = 0;
+    int differences = 0;
+    double differenceSquares = 0;
+
+    // Intervals first to last - 1 (interval i ends at peak i) are in the window
+    int first = 1, last = 1;
+
+    int windows = qFloor((peaks.last() - peaks.first() - window) / step) + 1;
+
+    for (int w = 0; w < qMax(windows, 1); w++)
+    {
+        double from = peaks.first() + w * step;
+        double to = from + window;
+
+        // Add the intervals entering the window
+        while (last < n && peaks[last] < to)
+        {
+            double rr = peaks[last] - peaks[last - 1] - shift;
+
+            count++;
+            sum += rr;
+            sumSquares += rr * rr;
+
+            if (last > first)
+            {
+                double d = (peaks[last] - peaks[last - 1]) - (peaks[last - 1] - peaks[last - 2]);
+
+                differences++;
+                differenceSquares += d * d;
+            }
+
+            last++;
+        }
+
+        // Evict the ones that left it
+        while (first < last && peaks[first] < from)
+        {
+            double rr = peaks[first] - peaks[first - 1] - shift;
+
+            count--;
+            sum -= rr;
+            sumSquares -= rr * rr;
+
+            if (first + 1 < last)
+            {
+                double d = (peaks[first + 1] - peaks[first]) - (peaks[first] - peaks[first - 1]);
+
+                differences--;
+                differenceSquares -= d * d;
+            }
+
+            first++;
+        }
+
+        // Drop the rounding residue whenever the window runs empty
+        if (count == 0)
+        {
+            sum = 0;
+            sumSquares = 0;
+            differenceSquares = 0;
+        }
+
+        result.start << from;
+        result.intervals << count;
+
+        if (count < 2)
+        {
+            result.meanHR << qQNaN();
+            result.sdnn << qQNaN();
+            result.rmssd << qQNaN();
+            continue;
+        }
+
+        double mean = sum / count;
+
+        result.meanHR << 60 / (shift + mean);
+        result.sdnn << qSqrt(qMax(0.0, (sumSquares - sum * mean) / (count - 1))) * 1000;
+        result.rmssd << (differences > 0 ? qSqrt(qMax(0.0, differenceSquares) / differences) * 1000 : qQNaN());
+    }
+
+    return result;
+}
@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2014-2015 Daniel Gromer
+ *
+ * This file is part of PeakMan.
+ *
+ * PeakMan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * PeakMan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PeakMan.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SLIDINGHRV_H
+#define SLIDINGHRV_H
+
+#include <QVector>
+
+// Heart rate variability in windows sliding over a long recording. The
+// window keeps running sums of its intervals and successive differences,
+// moving it adds the intervals that enter and evicts the ones that leave,
+// so all windows together take a single pass over the intervals.
+class SlidingHRV
+{
+public:
+    struct Result
+    {
+        QVector<double> start; // Window start, in seconds
+        QVector<int> intervals; // Intervals ending within the window
+        QVector<double> meanHR; // In beats per minute, NaN for windows with too few intervals
+        QVector<double> sdnn; // In ms
+        QVector<double> rmssd; // In ms
+        double window; // Length of the windows, in seconds
+
+        Result() : window(0) {}
+    };
+
+    SlidingHRV();
+
+    void setWindow(double seconds);
+    void setStep(double seconds);
+
+    double getWindow() const;
+
+    Result compute(const QVector<double> &peaks) const; // Peak positions in seconds
+
+private:
+    double window;
+    double step;
+};
+
+#endif // SLIDINGHRV_H
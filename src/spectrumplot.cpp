@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2014-2015 Daniel Gromer
+ *
+ * This file is part of PeakMan.
+ *
+ * PeakMan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * PeakMan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PeakMan.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "spectrumplot.h"
+
+SpectrumPlot::SpectrumPlot(QWidget *parent) : QCustomPlot(parent)
+{
+    // Band shading, filled down to the axis
+    lfBand = addGraph();
+    lfBand->setPen(Qt::NoPen);
+    lfBand->setBrush(QBrush(QColor(66, 113, 174, 60)));
+
+    hfBand = addGraph();
+    hfBand->setPen(Qt::NoPen);
+    hfBand->setBrush(QBrush(QColor(200, 40, 41, 60)));
+
+    comparisonPower = addGraph();
+    comparisonPower->setPen(QPen(QColor(150, 150, 150), 1, Qt::DashLine));
+
+    power = addGraph();
+    power->setPen(QPen(QColor(77, 77, 76), 2));
+
+    // Set axis labels
+    xAxis->setLabel("Frequency (Hz)");
+    yAxis->setLabel("PSD (ms^2/Hz)");
+
+    setInteractions(QCP::iRangeDrag | QCP::iRangeZoom);
+
+    // Appereance of axis grid
+    xAxis->grid()->setPen(QPen(QColor(200, 200, 200), 1, Qt::DotLine));
+    yAxis->grid()->setPen(QPen(QColor(200, 200, 200), 1, Qt::DotLine));
+    xAxis->grid()->setSubGridPen(QPen(QColor(220, 220, 220), 1, Qt::DotLine));
+    yAxis->grid()->setSubGridPen(QPen(QColor(220, 220, 220), 1, Qt::DotLine));
+    xAxis->grid()->setSubGridVisible(true);
+    yAxis->grid()->setSubGridVisible(true);
+
+    replot();
+}
+
+SpectrumPlot::~SpectrumPlot()
+{
+
+}
+
+void SpectrumPlot::plot(const HRVSpectrum::Result &spectrum, const HRVSpectrum::Result &comparison)
+{
+    QVector<double> lfFrequency, lfPower, hfFrequency, hfPower;
+    double maxPower = 0;
+
+    for (int k = 0; k < spectrum.frequency.size(); k++)
+    {
+        double f = spectrum.frequency[k];
+
+        if (f >= 0.04 && f <= 0.15)
+        {
+            lfFrequency << f;
+            lfPower << spectrum.power[k];
+        }
+        else if (f >= 0.15 && f <= 0.4)
+        {
+            hfFrequency << f;
+            hfPower << spectrum.power[k];
+        }
+
+        // Scale to the spectrum above the very low frequencies, which would
+        // dwarf everything else
+        if (f >= 0.04) maxPower = qMax(maxPower, spectrum.power[k]);
+    }
+
+    lfBand->setData(lfFrequency, lfPower);
+    hfBand->setData(hfFrequency, hfPower);
+    power->setData(spectrum.frequency, spectrum.power);
+    comparisonPower->setData(comparison.frequency, comparison.power);
+
+    xAxis->setRange(0, 0.5);
+    yAxis->setRange(0, maxPower * 1.1);
+
+    replot();
+}
+
+void SpectrumPlot::clear()
+{
+    lfBand->clearData();
+    hfBand->clearData();
+    power->clearData();
+    comparisonPower->clearData();
+
+    replot();
+}
@@ -0,0 +1,46 @@
+/*
+ * Copyright (C) 2014-2015 Daniel Gromer
+ *
+ * This file is part of PeakMan.
+ *
+ * PeakMan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * PeakMan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PeakMan.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SPECTRUMPLOT_H
+#define SPECTRUMPLOT_H
+
+#include "qcustomplot.h"
+#include "hrvspectrum.h"
+
+// HRV power spectrum with the LF and HF bands shaded, and an optional second
+// spectrum drawn for comparison
+class SpectrumPlot : public QCustomPlot
+{
+    Q_OBJECT
+
+public:
+    explicit SpectrumPlot(QWidget *parent);
+    ~SpectrumPlot();
+
+    void plot(const HRVSpectrum::Result &spectrum, const HRVSpectrum::Result &comparison);
+    void clear();
+
+private:
+    QCPGraph *lfBand;
+    QCPGraph *hfBand;
+    QCPGraph *power;
+    QCPGraph *comparisonPower;
+};
+
+#endif // SPECTRUMPLOT_H
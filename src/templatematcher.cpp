@@ -0,0 +1,306 @@
+/*
+ * Copyright (C) 2014-2015 Daniel Gromer
+ *
+ * This file is part of PeakMan.
+ *
+ * PeakMan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * PeakMan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PeakMan.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "templatematcher.h"
+#include <QtConcurrentMap>
+#include <qmath.h>
+#include <algorithm>
+
+// Beats used for the median template, spread over the recording
+static const int TemplateBeats = 500;
+
+// Beats per parallel work item, and the longest stretch of signal one work
+// item reads at once (long gaps without beats start a new item)
+static const int ChunkBeats = 256;
+static const int MaxChunkSamples = 1 << 20;
+
+struct MatchChunk
+{
+    const ECGSignal *signal;
+    const QVector<double> *kernel; // Zero-mean, unit-norm template
+    int before; // Template samples before the R peak
+    int radius; // Lags searched on each side
+    QVector<int> beats; // Sample positions
+    QVector<int> lags; // Best lag of each beat
+    QVector<double> correlation;
+};
+
+// Dot product of two contiguous arrays. Four independent sums break the
+// dependency chain, so the compiler can vectorize the loop.
+static inline double dot(const double *a, const double *b, int n)
+{
+    double s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    int i = 0;
+
+    for (; i + 4 <= n; i += 4)
+    {
+        s0 += a[i] * b[i];
+        s1 += a[i + 1] * b[i + 1];
+        s2 += a[i + 2] * b[i + 2];
+        s3 += a[i + 3] * b[i + 3];
+    }
+
+    for (; i < n; i++)
+    {
+        s0 += a[i] * b[i];
+    }
+
+    return (s0 + s1) + (s2 + s3);
+}
+
+static void matchChunk(MatchChunk &chunk)
+{
+    int m = chunk.kernel->size();
+    int n = chunk.signal->size();
+    int count = chunk.beats.size();
+
+    chunk.lags = QVector<int>(count, 0);
+    chunk.correlation = QVector<double>(count, 0);
+
+    // Samples needed by all beats of the chunk, read at once
+    int from = chunk.beats.first() - chunk.before - chunk.radius;
+    int to = chunk.beats.last() - chunk.before + m + chunk.radius;
+
+    if (from < 0 || to > n)
+    {
+        // Beats too close to the ends are left as they are
+        from = qMax(from, 0);
+        to = qMin(to, n);
+    }
+
+    QVector<double> x(to - from);
+    chunk.signal->read(from, x.size(), x.data());
+
+    const double *t = chunk.kernel->constData();
+
+    for (int b = 0; b < count; b++)
+    {
+        int first = chunk.beats[b] - chunk.before - chunk.radius - from;
+        int last = chunk.beats[b] - chunk.before + chunk.radius - from; // Start of the last window
+
+        if (first < 0 || last + m > x.size()) continue;
+
+        const double *w = x.constData() + first;
+
+        // Sums of the window for its mean and norm, slid along with the lag
+        double sum = 0, squares = 0;
+
+        for (int i = 0; i < m; i++)
+        {
+            sum += w[i];
+            squares += w[i] * w[i];
+        }
+
+        double best = -2;
+        int bestLag = 0;
+
+        for (int lag = 0; lag <= last - first; lag++)
+        {
+            if (lag > 0)
+            {
+                double out = w[lag - 1];
+                double in = w[lag + m - 1];
+                sum += in - out;
+                squares += in * in - out * out;
+            }
+
+            // The kernel has zero mean, so the window mean drops out of the
+            // numerator
+            double variance = squares - sum * sum / m;
+
+            if (variance <= 0) continue;
+
+            double ncc = dot(t, w + lag, m) / qSqrt(variance);
+
+            if (ncc > best)
+            {
+                best = ncc;
+                bestLag = lag - chunk.radius;
+            }
+        }
+
+        if (best > -2)
+        {
+            chunk.lags[b] = bestLag;
+            chunk.correlation[b] = best;
+        }
+    }
+}
+
+TemplateMatcher::TemplateMatcher()
+{
+    windowBefore = 0.08;
+    windowAfter = 0.12;
+    searchRadius = 0.04;
+    threshold = 0.8;
+}
+
+void TemplateMatcher::setWindow(double before, double after)
+{
+    windowBefore = before;
+    windowAfter = after;
+}
+
+void TemplateMatcher::setSearchRadius(double seconds)
+{
+    searchRadius = seconds;
+}
+
+void TemplateMatcher::setThreshold(double correlation)
+{
+    threshold = correlation;
+}
+
+double TemplateMatcher::getThreshold() const
+{
+    return threshold;
+}
+
+TemplateMatcher::Result TemplateMatcher::apply(const ECGSignal &signal, double sampleRate, const QVector<double> &peaks) const
+{
+    Result result;
+    result.positions = peaks;
+    result.correlation = QVector<double>(peaks.size(), 0);
+    result.ectopic = QVector<bool>(peaks.size(), false);
+
+    int before = qRound(windowBefore * sampleRate);
+    int after = qRound(windowAfter * sampleRate);
+    int radius = qRound(searchRadius * sampleRate);
+
+    if (peaks.size() < 3 || before + after < 2 || signal.isEmpty()) return result;
+
+    QVector<int> beats(peaks.size());
+
+    for (int i = 0; i < peaks.size(); i++)
+    {
+        beats[i] = qRound(peaks[i] * sampleRate);
+    }
+
+    // Median template, normalized to zero mean and unit norm so the NCC is a
+    // plain dot product
+    QVector<double> kernel = buildTemplate(signal, beats, before, after);
+
+    double mean = 0, norm = 0;
+
+    for (int i = 0; i < kernel.size(); i++) mean += kernel[i];
+
+    mean /= kernel.size();
+
+    for (int i = 0; i < kernel.size(); i++)
+    {
+        kernel[i] -= mean;
+        norm += kernel[i] * kernel[i];
+    }
+
+    if (norm <= 0) return result;
+
+    for (int i = 0; i < kernel.size(); i++) kernel[i] /= qSqrt(norm);
+
+    // Split the beats into work items and match them in parallel
+    QVector<MatchChunk> chunks;
+    QVector<int> chunkStart;
+
+    for (int i = 0; i < beats.size(); )
+    {
+        MatchChunk chunk;
+        chunk.signal = &signal;
+        chunk.kernel = &kernel;
+        chunk.before = before;
+        chunk.radius = radius;
+
+        chunkStart << i;
+
+        do
+        {
+            chunk.beats << beats[i++];
+        }
+        while (i < beats.size() && chunk.beats.size() < ChunkBeats && beats[i] - chunk.beats.first() < MaxChunkSamples);
+
+        chunks << chunk;
+    }
+
+    QtConcurrent::blockingMap(chunks, matchChunk);
+
+    for (int c = 0; c < chunks.size(); c++)
+    {
+        for (int b = 0; b < chunks[c].beats.size(); b++)
+        {
+            int i = chunkStart[c] + b;
+            double correlation = chunks[c].correlation[b];
+
+            result.correlation[i] = correlation;
+
+            // Beats that could not be compared (at the ends of the signal) are
+            // neither moved nor flagged
+            if (correlation == 0) continue;
+
+            if (correlation < threshold)
+            {
+                result.ectopic[i] = true;
+            }
+            else
+            {
+                result.positions[i] = (beats[i] + chunks[c].lags[b]) / sampleRate;
+            }
+        }
+    }
+
+    return result;
+}
+
+QVector<double> TemplateMatcher::buildTemplate(const ECGSignal &signal, const QVector<int> &beats, int before, int after) const
+{
+    int m = before + after;
+    int step = qMax(1, beats.size() / TemplateBeats);
+
+    // Windows of the sampled beats, one row per beat
+    QVector<double> windows;
+    int rows = 0;
+
+    for (int i = 0; i < beats.size(); i += step)
+    {
+        int from = beats[i] - before;
+
+        if (from < 0 || from + m > signal.size()) continue;
+
+        windows.resize((rows + 1) * m);
+        signal.read(from, m, windows.data() + rows * m);
+        rows++;
+    }
+
+    QVector<double> kernel(m, 0);
+
+    if (rows == 0) return kernel;
+
+    // Median of each column
+    QVector<double> column(rows);
+
+    for (int j = 0; j < m; j++)
+    {
+        for (int r = 0; r < rows; r++)
+        {
+            column[r] = windows[r * m + j];
+        }
+
+        std::nth_element(column.begin(), column.begin() + rows / 2, column.end());
+        kernel[j] = column[rows / 2];
+    }
+
+    return kernel;
+}
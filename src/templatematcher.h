@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2014-2015 Daniel Gromer
+ *
+ * This file is part of PeakMan.
+ *
+ * PeakMan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * PeakMan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PeakMan.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TEMPLATEMATCHER_H
+#define TEMPLATEMATCHER_H
+
+#include <QVector>
+#include "ecgsignal.h"
+
+// Beat classification by template matching. A median QRS template is built
+// from the detected beats, then every beat is compared to it with the
+// normalized cross-correlation (NCC) over a small range of lags. Beats are
+// moved to the lag with the highest correlation, beats whose best correlation
+// stays below the threshold have an unusual morphology and count as ectopic.
+class TemplateMatcher
+{
+public:
+    struct Result
+    {
+        QVector<double> positions; // Refined, in seconds (ectopic beats keep their position)
+        QVector<double> correlation; // Best NCC of each beat, 0 if it could not be compared
+        QVector<bool> ectopic;
+    };
+
+    TemplateMatcher();
+
+    void setWindow(double before, double after); // Template around the R peak, in seconds
+    void setSearchRadius(double seconds);
+    void setThreshold(double correlation);
+
+    double getThreshold() const;
+
+    Result apply(const ECGSignal &signal, double sampleRate, const QVector<double> &peaks) const;
+
+private:
+    QVector<double> buildTemplate(const ECGSignal &signal, const QVector<int> &beats, int before, int after) const;
+
+    double windowBefore;
+    double windowAfter;
+    double searchRadius;
+    double threshold;
+};
+
+#endif // TEMPLATEMATCHER_H
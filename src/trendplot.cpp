@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2014-2015 Daniel Gromer
+ *
+ * This file is part of PeakMan.
+ *
+ * PeakMan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * PeakMan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PeakMan.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "trendplot.h"
+
+TrendPlot::TrendPlot(QWidget *parent) : QCustomPlot(parent)
+{
+    sdnn = addGraph();
+    sdnn->setName("SDNN");
+    sdnn->setPen(QPen(QColor(66, 113, 174), 2));
+
+    rmssd = addGraph();
+    rmssd->setName("RMSSD");
+    rmssd->setPen(QPen(QColor(200, 40, 41), 2));
+
+    meanHR = addGraph(xAxis, yAxis2);
+    meanHR->setName("Mean HR");
+    meanHR->setPen(QPen(QColor(77, 77, 76)));
+
+    // Set axis labels
+    xAxis->setLabel("Time (s)");
+    yAxis->setLabel("SDNN, RMSSD (ms)");
+    yAxis2->setLabel("Heart rate (bpm)");
+    yAxis2->setVisible(true);
+
+    legend->setVisible(true);
+    legend->setFont(QFont(font().family(), 8));
+
+    // Only the time axis moves, like in the ecg plot
+    setInteractions(QCP::iRangeDrag | QCP::iRangeZoom);
+    axisRect()->setRangeZoom(xAxis->orientation());
+    axisRect()->setRangeDrag(xAxis->orientation());
+
+    // Appereance of axis grid
+    xAxis->grid()->setPen(QPen(QColor(200, 200, 200), 1, Qt::DotLine));
+    yAxis->grid()->setPen(QPen(QColor(200, 200, 200), 1, Qt::DotLine));
+    xAxis->grid()->setSubGridPen(QPen(QColor(220, 220, 220), 1, Qt::DotLine));
+    yAxis->grid()->setSubGridPen(QPen(QColor(220, 220, 220), 1, Qt::DotLine));
+    xAxis->grid()->setSubGridVisible(true);
+    yAxis->grid()->setSubGridVisible(true);
+
+    replot();
+}
+
+TrendPlot::~TrendPlot()
+{
+
+}
+
+void TrendPlot::plot(const SlidingHRV::Result &trend, double window)
+{
+    // Each window is drawn at its center
+    QVector<double> time(trend.start.size());
+
+    for (int i = 0; i < time.size(); i++)
+    {
+        time[i] = trend.start[i] + window / 2;
+    }
+
+    sdnn->setData(time, trend.sdnn);
+    rmssd->setData(time, trend.rmssd);
+    meanHR->setData(time, trend.meanHR);
+
+    // Value axes only, the time axis stays with the ecg plot. Windows with
+    // too few intervals are NaN, they leave gaps and don't count here.
+    double maxVariability = 0;
+    QCPRange heartRate(qInf(), -qInf());
+
+    for (int i = 0; i < time.size(); i++)
+    {
+        if (!qIsNaN(trend.sdnn[i])) maxVariability = qMax(maxVariability, trend.sdnn[i]);
+        if (!qIsNaN(trend.rmssd[i])) maxVariability = qMax(maxVariability, trend.rmssd[i]);
+
+        if (!qIsNaN(trend.meanHR[i]))
+        {
+            heartRate.lower = qMin(heartRate.lower, trend.meanHR[i]);
+            heartRate.upper = qMax(heartRate.upper, trend.meanHR[i]);
+        }
+    }
+
+    yAxis->setRange(0, maxVariability > 0 ? maxVariability * 1.1 : 100);
+
+    if (heartRate.lower <= heartRate.upper)
+    {
+        yAxis2->setRange(heartRate.lower - 5, heartRate.upper + 5);
+    }
+
+    replot();
+}
+
+void TrendPlot::clear()
+{
+    sdnn->clearData();
+    rmssd->clearData();
+    meanHR->clearData();
+
+    replot();
+}
+
+void TrendPlot::setTimeRange(const QCPRange &range)
+{
+    xAxis->setRange(range);
+
+    // Every scroll of the ecg plot ends up here, a hidden trend is replotted
+    // once it is shown again
+    if (isVisible()) replot();
+}
+
+void TrendPlot::showEvent(QShowEvent *event)
+{
+    QCustomPlot::showEvent(event);
+
+    replot();
+}
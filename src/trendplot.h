@@ -0,0 +1,50 @@
+/*
+ * Copyright (C) 2014-2015 Daniel Gromer
+ *
+ * This file is part of PeakMan.
+ *
+ * PeakMan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * PeakMan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PeakMan.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRENDPLOT_H
+#define TRENDPLOT_H
+
+#include "qcustomplot.h"
+#include "slidinghrv.h"
+
+// Sliding-window HRV over time, on the same time axis as the ecg plot
+class TrendPlot : public QCustomPlot
+{
+    Q_OBJECT
+
+public:
+    explicit TrendPlot(QWidget *parent);
+    ~TrendPlot();
+
+    void plot(const SlidingHRV::Result &trend, double window);
+    void clear();
+
+public slots:
+    void setTimeRange(const QCPRange &range); // Follows the ecg plot
+
+protected:
+    void showEvent(QShowEvent *event);
+
+private:
+    QCPGraph *sdnn;
+    QCPGraph *rmssd;
+    QCPGraph *meanHR;
+};
+
+#endif // TRENDPLOT_H